@@ -0,0 +1,60 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <cstdint>
+
+namespace fuzz {
+
+namespace detail {
+
+/*
+ * Bit masks of where every byte value occurs in a string, split into
+ * 64 bit blocks. This is the "pattern" side of the bit-parallel LCS
+ * algorithm (Hyyrö, "Bit-Parallel LCS-length Computation Revisited").
+ * Building it is O(256 * blocks), so it pays off when the same string
+ * is compared against many others.
+ */
+class pattern_match_vector {
+public:
+    pattern_match_vector() = default;
+    pattern_match_vector(const char *s, size_t len) { assign(s, len); }
+
+    void assign(const char *s, size_t len);
+
+    size_t size() const { return len_; }
+    size_t block_count() const { return blocks_; }
+
+    uint64_t get(size_t block, unsigned char ch) const { return masks_[ch * blocks_ + block]; }
+    const uint64_t *data() const { return masks_.data(); }
+
+private:
+    size_t len_ = 0;
+    size_t blocks_ = 0;
+    vector<uint64_t> masks_;
+};
+
+/* Length of the longest common subsequence of the pattern and s2. */
+size_t lcs_length(const pattern_match_vector &pm, const char *s2, size_t len2);
+size_t lcs_length(const char *s1, size_t len1, const char *s2, size_t len2);
+
+/*
+ * The Levenshtein ratio of two strings, given the length of their longest
+ * common subsequence. wrapper::ratio counts a replacement as two edits, so
+ * its distance is len1 + len2 - 2 * lcs and both agree exactly.
+ */
+unsigned int lcs_ratio(size_t lcs, size_t len1, size_t len2);
+
+/*
+ * The best lcs_ratio() of s1 against a window of s2, for len1 <= len2. The
+ * windows are every len1 long substring of s2 plus the shorter ones that
+ * run into its end. Windows that can't beat the best so far (or reach
+ * score_cutoff) by character counts alone are skipped, and the search
+ * stops at the first perfect match. Returns 0 if score_cutoff isn't reached.
+ */
+unsigned int partial_lcs_ratio(const char *s1, size_t len1, const char *s2, size_t len2,
+                               unsigned int score_cutoff);
+
+}  // ns detail
+
+}  // ns fuzz
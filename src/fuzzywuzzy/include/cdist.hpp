@@ -0,0 +1,137 @@
+#pragma once
+
+#include "common.hpp"
+#include "fuzzywuzzy.hpp"
+#include "parallel.hpp"
+#include "utils.hpp"
+
+#include <cstdint>
+
+namespace fuzz {
+
+/*
+ * Batch scoring of every query against every choice.
+ *
+ * The scorer is one of the prepared scorer classes (cached_ratio,
+ * cached_token_sort_ratio, cached_weighted_ratio) and is given as a template
+ * argument, e.g.
+ *
+ *     auto scores = fuzz::cdist<fuzz::cached_ratio>(queries, choices, 80);
+ *
+ * Every string is processed exactly once and each query's scorer is built
+ * once, so a cell costs a single score() call. The result is the same as
+ * calling the matching free function (with full_process) for each pair.
+ *
+ * workers == 0 uses one thread per hardware thread.
+ */
+
+/* A (query, choice) pair that reached the cutoff. */
+struct cdist_match {
+    size_t query;
+    size_t choice;
+    uint8_t score;
+};
+
+namespace detail {
+
+/* Queries per task, they share one pass over each block of choices. */
+constexpr size_t cdist_query_block = 16;
+/* Choices per block, small enough for their strings to stay in cache. */
+constexpr size_t cdist_choice_block = 256;
+
+inline vector<string> cdist_process(const vector<string> &strings)
+{
+    vector<string> processed;
+    processed.reserve(strings.size());
+    for (const auto &s : strings)
+        processed.push_back(utils::full_process(s));
+    return processed;
+}
+
+/*
+ * Scores every pair, handing out blocks of queries to the workers. Within a
+ * task the choices are walked in blocks, and each block is scored against
+ * all queries of the task before moving on.
+ * emit(worker, query, choice, score) gets called for every cell.
+ */
+template <typename Scorer, typename Emit>
+void cdist(const vector<string> &queries, const vector<string> &choices, const unsigned int score_cutoff,
+           const bool full_process, unsigned int workers, Emit &&emit)
+{
+    vector<string> processed_queries, processed_choices;
+    const auto &p_queries = full_process ? (processed_queries = cdist_process(queries)) : queries;
+    const auto &p_choices = full_process ? (processed_choices = cdist_process(choices)) : choices;
+
+    const size_t tasks = (p_queries.size() + cdist_query_block - 1) / cdist_query_block;
+    parallel_for(tasks, workers, [&](size_t task, unsigned int worker) {
+        const size_t q_begin = task * cdist_query_block;
+        const size_t q_end = std::min(q_begin + cdist_query_block, p_queries.size());
+
+        vector<Scorer> scorers;
+        scorers.reserve(q_end - q_begin);
+        for (size_t q = q_begin; q < q_end; q++)
+            scorers.emplace_back(p_queries[q], false);
+
+        for (size_t c_begin = 0; c_begin < p_choices.size(); c_begin += cdist_choice_block) {
+            const size_t c_end = std::min(c_begin + cdist_choice_block, p_choices.size());
+            for (size_t q = q_begin; q < q_end; q++) {
+                const Scorer &scorer = scorers[q - q_begin];
+                for (size_t c = c_begin; c < c_end; c++)
+                    emit(worker, q, c, scorer.score(p_choices[c], score_cutoff));
+            }
+        }
+    });
+}
+
+}  // ns detail
+
+/*
+ * Returns a queries.size() x choices.size() matrix in row-major order, i.e.
+ * the score of queries[i] against choices[j] is at i * choices.size() + j.
+ * Scores below score_cutoff are 0.
+ */
+template <typename Scorer>
+vector<uint8_t> cdist(const vector<string> &queries, const vector<string> &choices,
+                      const unsigned int score_cutoff = 0, const unsigned int workers = 0,
+                      const bool full_process = true)
+{
+    vector<uint8_t> matrix(queries.size() * choices.size());
+    const size_t cols = choices.size();
+
+    /* Workers write disjoint rows, so no locking is needed. */
+    detail::cdist<Scorer>(queries, choices, score_cutoff, full_process, workers,
+                          [&](unsigned int, size_t q, size_t c, unsigned int score) {
+                              matrix[q * cols + c] = static_cast<uint8_t>(score);
+                          });
+    return matrix;
+}
+
+/*
+ * Returns only the pairs scoring at least score_cutoff (which should be
+ * above 0, otherwise every pair is returned), ordered by query and then
+ * by choice.
+ */
+template <typename Scorer>
+vector<cdist_match> cdist_sparse(const vector<string> &queries, const vector<string> &choices,
+                                 const unsigned int score_cutoff, const unsigned int workers = 0,
+                                 const bool full_process = true)
+{
+    vector<vector<cdist_match>> found(detail::worker_count(workers));
+
+    detail::cdist<Scorer>(queries, choices, score_cutoff, full_process, workers,
+                          [&](unsigned int worker, size_t q, size_t c, unsigned int score) {
+                              if (score >= score_cutoff)
+                                  found[worker].push_back({q, c, static_cast<uint8_t>(score)});
+                          });
+
+    vector<cdist_match> matches;
+    for (const auto &f : found)
+        matches.insert(matches.end(), f.cbegin(), f.cend());
+
+    std::sort(matches.begin(), matches.end(), [](const cdist_match &a, const cdist_match &b) {
+        return a.query != b.query ? a.query < b.query : a.choice < b.choice;
+    });
+    return matches;
+}
+
+}  // ns fuzz
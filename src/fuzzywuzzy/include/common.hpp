@@ -1,9 +1,9 @@
 #pragma once
 
-#include <experimental/string_view>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using std::vector;
-using std::experimental::string_view;
+using std::string_view;
 using std::string;
@@ -1,21 +1,30 @@
 #pragma once
 
 #include "common.hpp"
+#include "bitparallel.hpp"
 
 namespace /* I'm in your mind... */ fuzz {
 
+/*
+ * Every scorer takes an optional score_cutoff in [0,100]. A result below
+ * it is returned as 0, and the scorer stops working as soon as it knows
+ * the cutoff can't be reached.
+ */
+
 /*                          */
 /* Basic scoring functions. */
 /*                          */
 
 /* Calculates a Levenshtein simple ratio between the string. */
-unsigned int ratio(const string &s1, const string &s2, const bool full_process = true);
+unsigned int ratio(string_view s1, string_view s2, const bool full_process = true,
+                   const unsigned int score_cutoff = 0);
 
 /*
  * Return the ratio of the most similar substring
  * as a number between 0 and 100.
  */
-unsigned int partial_ratio(const string &s1, const string &s2, const bool full_process = true);
+unsigned int partial_ratio(string_view s1, string_view s2, const bool full_process = true,
+                           const unsigned int score_cutoff = 0);
 
 /*                             */
 /* Advanced scoring functions. */
@@ -25,8 +34,10 @@ unsigned int partial_ratio(const string &s1, const string &s2, const bool full_p
  * Returns a measure of the strings' similarity between 0 and 100
  * but sorting the token before comparing.
  */
-unsigned int token_sort_ratio(const string &s1, const string &s2, const bool full_process = true);
-unsigned int token_sort_partial_ratio(const string &s1, const string &s2, const bool full_process = true);
+unsigned int token_sort_ratio(string_view s1, string_view s2, const bool full_process = true,
+                              const unsigned int score_cutoff = 0);
+unsigned int token_sort_partial_ratio(string_view s1, string_view s2, const bool full_process = true,
+                                      const unsigned int score_cutoff = 0);
 
 /*
  * Splits the strings into tokens and computes intersections and
@@ -34,13 +45,15 @@ unsigned int token_sort_partial_ratio(const string &s1, const string &s2, const
  * is then built up and is compared using the simple ratio algorithm.
  * Useful for strings where words appear redundantly.
  */
-unsigned int token_set_ratio(const string &s1, const string &s2, const bool full_process = true);
+unsigned int token_set_ratio(string_view s1, string_view s2, const bool full_process = true,
+                             const unsigned int score_cutoff = 0);
 
 /*
  * Returns the ratio of the most similar substring as a number
  * between 0 and 100 but sorting the token before comparing.
  */
-unsigned int partial_token_set_ratio(const string &s1, const string &s2, const bool full_process = true);
+unsigned int partial_token_set_ratio(string_view s1, string_view s2, const bool full_process = true,
+                                     const unsigned int score_cutoff = 0);
 
 /*                 */
 /* Combination API */
@@ -51,7 +64,8 @@ unsigned int partial_token_set_ratio(const string &s1, const string &s2, const b
  * Runs utils::full_process on both strings.
  * Short circuits if either string is empty after processing.
  */
-unsigned int quick_ratio(const string &s1, const string &s2, const bool full_process = true);
+unsigned int quick_ratio(string_view s1, string_view s2, const bool full_process = true,
+                         const unsigned int score_cutoff = 0);
 
 /*
  * Returns a measure of the strings' similarity between 0 and 100, using different algorithms.
@@ -76,7 +90,69 @@ unsigned int quick_ratio(const string &s1, const string &s2, const bool full_pro
  *
  *  #. Take the highest value from these results, round it, and return
  *     as an integer.
+ *
+ * Each string is processed, split and sorted only once, and all the ratio
+ * functions above work on that. With full_process == false the strings are
+ * taken to be processed already.
+ */
+unsigned int weighted_ratio(string_view s1, string_view s2, const bool full_process = true,
+                            const unsigned int score_cutoff = 0);
+
+/*                  */
+/* Prepared scorers */
+/*                  */
+
+/*
+ * Versions of the scorers above for comparing one string against many.
+ * Everything that only depends on s1 (processing it, sorting its tokens
+ * and building the bit-parallel pattern masks) is done once by the
+ * constructor, and score(s2) returns the same value as the matching free
+ * function would for (s1, s2).
+ *
+ * The token based scorers re-run utils::full_process on intermediate
+ * strings; with full_process == false they expect s1 and s2 to already
+ * be processed, which is how process.cpp calls its scorers.
+ *
+ * score() is const and does not touch any shared state, so one prepared
+ * scorer can be used from several threads at once.
  */
-unsigned int weighted_ratio(const string &s1, const string &s2, const bool full_process = true);
+class cached_ratio {
+public:
+    explicit cached_ratio(string_view s1, const bool full_process = true);
+
+    unsigned int score(string_view s2, const unsigned int score_cutoff = 0) const;
+
+private:
+    bool full_process_;
+    string s1_;
+    detail::pattern_match_vector pm_;
+};
+
+class cached_token_sort_ratio {
+public:
+    explicit cached_token_sort_ratio(string_view s1, const bool full_process = true);
+
+    unsigned int score(string_view s2, const unsigned int score_cutoff = 0) const;
+
+private:
+    bool full_process_;
+    string sorted1_;
+    detail::pattern_match_vector pm_;
+};
+
+class cached_weighted_ratio {
+public:
+    explicit cached_weighted_ratio(string_view s1, const bool full_process = true);
+
+    unsigned int score(string_view s2, const unsigned int score_cutoff = 0) const;
+
+private:
+    bool full_process_;
+    string s1_;
+    string sorted1_;
+    vector<string> tokens1_;    /* sorted, without duplicates */
+    detail::pattern_match_vector pm_;
+    detail::pattern_match_vector sorted_pm_;
+};
 
 /* I'm not in your mind */ }
@@ -95,6 +95,37 @@ typedef struct {
     size_t len;
 } LevMatchingBlock;
 
+/* Buffers of a scratch context (see LevScratch). */
+typedef enum {
+    LEV_SCRATCH_WORK = 0,  /* cost rows and matrices */
+    LEV_SCRATCH_EDITOPS,  /* lev_editops_find_ex() result */
+    LEV_SCRATCH_OPCODES,  /* lev_editops_to_opcodes_ex() result */
+    LEV_SCRATCH_BLOCKS,  /* lev_opcodes_matching_blocks_ex() result */
+    LEV_SCRATCH_LAST
+} LevScratchSlot;
+
+/* Work area (in size_t units) kept inside the context, enough for the cost
+ * matrix of two ~50 character strings. */
+#define LEV_SCRATCH_SMALL 1024
+
+/* Scratch context.
+ * Reusable memory for the _ex functions, so repeated calls don't have to
+ * go through malloc() and free().  Each slot is grown as needed and kept,
+ * results stay valid until the next call filling the same slot.  A context
+ * must not be used by two threads at once; keep one per thread.
+ */
+typedef struct {
+    void *buf[LEV_SCRATCH_LAST];
+    size_t size[LEV_SCRATCH_LAST];
+    size_t small[LEV_SCRATCH_SMALL];
+} LevScratch;
+
+void
+lev_scratch_init(LevScratch *scratch);
+
+void
+lev_scratch_free(LevScratch *scratch);
+
 size_t
 lev_edit_distance(size_t len1,
                   const lev_byte *string1,
@@ -102,6 +133,14 @@ lev_edit_distance(size_t len1,
                   const lev_byte *string2,
                   int xcost);
 
+size_t
+lev_edit_distance_ex(size_t len1,
+                     const lev_byte *string1,
+                     size_t len2,
+                     const lev_byte *string2,
+                     int xcost,
+                     LevScratch *scratch);
+
 size_t
 lev_u_edit_distance(size_t len1,
                     const lev_wchar *string1,
@@ -116,6 +155,14 @@ lev_editops_find(size_t len1,
                  const lev_byte *string2,
                  size_t *n);
 
+LevEditOp*
+lev_editops_find_ex(size_t len1,
+                    const lev_byte *string1,
+                    size_t len2,
+                    const lev_byte *string2,
+                    size_t *n,
+                    LevScratch *scratch);
+
 LevOpCode*
 lev_editops_to_opcodes(size_t n,
                        const LevEditOp *ops,
@@ -123,6 +170,14 @@ lev_editops_to_opcodes(size_t n,
                        size_t len1,
                        size_t len2);
 
+LevOpCode*
+lev_editops_to_opcodes_ex(size_t n,
+                          const LevEditOp *ops,
+                          size_t *nb,
+                          size_t len1,
+                          size_t len2,
+                          LevScratch *scratch);
+
 LevMatchingBlock*
 lev_opcodes_matching_blocks(size_t len1,
                             __attribute__((unused)) size_t len2,
@@ -130,6 +185,14 @@ lev_opcodes_matching_blocks(size_t len1,
                             const LevOpCode *bops,
                             size_t *nmblocks);
 
+LevMatchingBlock*
+lev_opcodes_matching_blocks_ex(size_t len1,
+                               __attribute__((unused)) size_t len2,
+                               size_t nb,
+                               const LevOpCode *bops,
+                               size_t *nmblocks,
+                               LevScratch *scratch);
+
 LevMatchingBlock*
 lev_editops_matching_blocks(size_t len1,
                             size_t len2,
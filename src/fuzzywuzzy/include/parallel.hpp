@@ -0,0 +1,55 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace fuzz {
+
+namespace detail {
+
+/* The number of threads to use when the caller asked for 0, i.e. "all of them". */
+inline unsigned int worker_count(unsigned int workers)
+{
+    if (workers == 0)
+        workers = std::thread::hardware_concurrency();
+    return std::max(workers, 1u);
+}
+
+/*
+ * Calls fn(task, worker) for every task in [0, count) from up to workers
+ * threads. Tasks are handed out one at a time from a shared counter, so
+ * uneven tasks still keep every thread busy. worker is in [0, workers)
+ * and lets fn keep per-thread results without locking.
+ * With one worker (or one task) everything runs on the calling thread.
+ */
+template <typename Fn>
+void parallel_for(size_t count, unsigned int workers, Fn &&fn)
+{
+    workers = static_cast<unsigned int>(std::min<size_t>(worker_count(workers), count));
+    if (workers <= 1) {
+        for (size_t task = 0; task < count; task++)
+            fn(task, 0u);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    auto run = [&](unsigned int worker) {
+        for (size_t task = next++; task < count; task = next++)
+            fn(task, worker);
+    };
+
+    vector<std::thread> threads;
+    for (unsigned int worker = 1; worker < workers; worker++)
+        threads.emplace_back(run, worker);
+    run(0);
+
+    for (auto &t : threads)
+        t.join();
+}
+
+}  // ns detail
+
+}  // ns fuzz
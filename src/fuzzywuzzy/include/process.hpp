@@ -6,6 +6,7 @@
 
 #include "utils.hpp"
 #include "fuzzywuzzy.hpp"
+#include "parallel.hpp"
 
 namespace fuzz
 {
@@ -16,28 +17,28 @@ using std::function;
  * contains the matches and their respective scores.
  */
 vector<pair<string, int>> extractWithoutOrder(const string& query, const vector<string>& choices
-    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool)> scorer=weighted_ratio
+    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool, const unsigned int)> scorer=weighted_ratio
     , int score_cutoff=0);
 
 /*
  * Convenience function for getting the choices with best scores.
  */
 vector<pair<string, int>> extractBests(const string& query, const vector<string>& choices
-    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool)> scorer=weighted_ratio
+    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool, const unsigned int)> scorer=weighted_ratio
     , int score_cutoff = 0, intmax_t limit = 5);
 
 /*
  * Convenience function for getting the choices with best scores.
  */
 vector<pair<string, int>> extract(const string& query, const vector<string>& choices
-    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool)> scorer=weighted_ratio
+    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool, const unsigned int)> scorer=weighted_ratio
     , intmax_t limit = 5);
 
 /*
  * This is a convenience method which returns the single best choice.
  */
 vector<pair<string, int>> extractOne(const string& query, const vector<string>& choices
-    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool)> scorer=weighted_ratio
+    , function<string(string)> processor=utils::full_process, function<int(string, string, const bool, const unsigned int)> scorer=weighted_ratio
     , int score_cutoff = 0);
 /*
  * This convenience function takes a list of strings containing duplicates and uses fuzzy matching to identify
@@ -49,9 +50,163 @@ vector<pair<string, int>> extractOne(const string& query, const vector<string>&
  * Note: as the threshold DECREASES the number of duplicates that are found INCREASES. This means that the
  *     returned deduplicated list will likely be shorter. Raise the threshold for fuzzy_dedupe to be less
  *     sensitive. 
+ *
+ * The scorer runs once per pair of distinct processed strings, on up to workers threads at once
+ * (0 means one per hardware thread).
  */
 vector<string> dedupe(const vector<string>& contains_dupes, int threshold=70
-    , function<int(string, string, const bool)> scorer=token_set_ratio);
+    , function<int(string, string, const bool, const unsigned int)> scorer=token_set_ratio
+    , unsigned int workers = 1);
+
+/*
+ * Templated versions of the extract functions. The scorer is one of the prepared
+ * scorer classes (cached_ratio, cached_token_sort_ratio, cached_weighted_ratio)
+ * given as a template argument and the processor is any callable taking and
+ * returning a string, e.g.
+ *
+ *     auto best = fuzz::extractOne<fuzz::cached_weighted_ratio>(query, choices);
+ *
+ * The query and every choice are run through the processor and then
+ * utils::full_process exactly once (once in total if the processor is
+ * utils::full_process itself), and the query's scorer is only built once.
+ * With workers != 1 the choices are scored on that many threads (0 means one
+ * per hardware thread); the results do not depend on the number of workers.
+ * Choices with equal scores are ordered by their position in choices. With
+ * several workers the processor is called from all of them at once.
+ */
+namespace detail {
+
+inline bool is_full_process(string (*processor)(string))
+{
+    return processor == utils::full_process;
+}
+
+template <typename Processor>
+bool is_full_process(const Processor &)
+{
+    return false;
+}
+
+template <typename Processor>
+string extract_process(Processor &processor, string_view s)
+{
+    string processed = processor(string(s.data(), s.size()));
+    return is_full_process(processor) ? processed : utils::full_process(processed);
+}
+
+/* Choices per task handed to a worker. */
+constexpr size_t extract_block = 256;
+
+/* Calls emit(worker, index, score) for every choice scoring at least score_cutoff. */
+template <typename Scorer, typename Processor, typename Emit>
+void extract_scores(string_view query, const vector<string> &choices, Processor &processor,
+                    const int score_cutoff, const unsigned int workers, Emit &&emit)
+{
+    const Scorer scorer(extract_process(processor, query), false);
+    const unsigned int cutoff = static_cast<unsigned int>(std::max(0, score_cutoff));
+
+    const size_t tasks = (choices.size() + extract_block - 1) / extract_block;
+    parallel_for(tasks, workers, [&](size_t task, unsigned int worker) {
+        const size_t end = std::min((task + 1) * extract_block, choices.size());
+        for (size_t i = task * extract_block; i < end; i++) {
+            const int score = static_cast<int>(scorer.score(extract_process(processor, choices[i]), cutoff));
+            if (score >= score_cutoff)
+                emit(worker, i, score);
+        }
+    });
+}
+
+/* (index, score), ordered best first. */
+using extract_hit = pair<size_t, int>;
+
+inline bool extract_better(const extract_hit &a, const extract_hit &b)
+{
+    return a.second != b.second ? a.second > b.second : a.first < b.first;
+}
+
+inline vector<pair<string, int>> extract_results(const vector<extract_hit> &hits, const vector<string> &choices)
+{
+    vector<pair<string, int>> results;
+    results.reserve(hits.size());
+    for (const auto &hit : hits)
+        results.emplace_back(choices[hit.first], hit.second);
+    return results;
+}
+
+}  // ns detail
+
+template <typename Scorer, typename Processor = string (*)(string)>
+vector<pair<string, int>> extractWithoutOrder(string_view query, const vector<string>& choices
+    , int score_cutoff = 0, unsigned int workers = 1, Processor processor = utils::full_process)
+{
+    vector<vector<detail::extract_hit>> found(detail::worker_count(workers));
+    detail::extract_scores<Scorer>(query, choices, processor, score_cutoff, workers,
+        [&](unsigned int worker, size_t index, int score) { found[worker].emplace_back(index, score); });
+
+    /* Back into the order of choices. */
+    vector<detail::extract_hit> hits;
+    for (const auto& f : found)
+        hits.insert(hits.end(), f.cbegin(), f.cend());
+    std::sort(hits.begin(), hits.end());
+
+    return detail::extract_results(hits, choices);
+}
+
+/*
+ * Keeps the best limit results in a bounded heap per worker while scoring, so
+ * no more than limit results are held at a time. A negative limit returns
+ * every result, in the order of choices.
+ */
+template <typename Scorer, typename Processor = string (*)(string)>
+vector<pair<string, int>> extractBests(string_view query, const vector<string>& choices
+    , int score_cutoff = 0, intmax_t limit = 5, unsigned int workers = 1
+    , Processor processor = utils::full_process)
+{
+    if(limit < 0)
+        return extractWithoutOrder<Scorer>(query, choices, score_cutoff, workers, processor);
+
+    const size_t k = static_cast<size_t>(limit);
+    if(k == 0)
+        return {};
+
+    /* The heap's front is the worst of the kept results. */
+    auto push = [k](vector<detail::extract_hit>& heap, const detail::extract_hit& hit) {
+        if(heap.size() < k) {
+            heap.push_back(hit);
+            std::push_heap(heap.begin(), heap.end(), detail::extract_better);
+        } else if(detail::extract_better(hit, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), detail::extract_better);
+            heap.back() = hit;
+            std::push_heap(heap.begin(), heap.end(), detail::extract_better);
+        }
+    };
+
+    vector<vector<detail::extract_hit>> heaps(detail::worker_count(workers));
+    detail::extract_scores<Scorer>(query, choices, processor, score_cutoff, workers,
+        [&](unsigned int worker, size_t index, int score) { push(heaps[worker], {index, score}); });
+
+    vector<detail::extract_hit> best = std::move(heaps[0]);
+    for(size_t i = 1; i < heaps.size(); i++)
+        for(const auto& hit : heaps[i])
+            push(best, hit);
+
+    std::sort(best.begin(), best.end(), detail::extract_better);
+    return detail::extract_results(best, choices);
+}
+
+template <typename Scorer, typename Processor = string (*)(string)>
+vector<pair<string, int>> extract(string_view query, const vector<string>& choices
+    , intmax_t limit = 5, unsigned int workers = 1, Processor processor = utils::full_process)
+{
+    return extractBests<Scorer>(query, choices, 0, limit, workers, processor);
+}
+
+template <typename Scorer, typename Processor = string (*)(string)>
+vector<pair<string, int>> extractOne(string_view query, const vector<string>& choices
+    , int score_cutoff = 0, unsigned int workers = 1, Processor processor = utils::full_process)
+{
+    return extractBests<Scorer>(query, choices, score_cutoff, 1, workers, processor);
+}
 
 } // ns fuzz
 
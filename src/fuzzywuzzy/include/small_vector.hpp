@@ -0,0 +1,72 @@
+#pragma once
+
+#include "common.hpp"
+
+#include <type_traits>
+
+namespace fuzz {
+
+namespace detail {
+
+/*
+ * A vector that keeps its first N elements inside itself and only moves
+ * them to the heap once it grows past that. Meant for short lists that
+ * live on the stack for the duration of a call, such as the tokens of a
+ * string, so it only holds trivially copyable types and can't be copied.
+ */
+template <typename T, size_t N>
+class small_vector {
+    static_assert(std::is_trivially_copyable<T>::value, "small_vector only holds trivially copyable types");
+
+public:
+    small_vector() = default;
+    small_vector(const small_vector &) = delete;
+    small_vector &operator=(const small_vector &) = delete;
+
+    void push_back(const T &value)
+    {
+        if (!on_heap_ && size_ == N) {
+            heap_.assign(inline_, inline_ + N);
+            on_heap_ = true;
+        }
+
+        if (on_heap_)
+            heap_.push_back(value);
+        else
+            inline_[size_] = value;
+        size_++;
+    }
+
+    /* Drops everything from position n on. */
+    void truncate(size_t n)
+    {
+        if (n >= size_)
+            return;
+        size_ = n;
+        if (on_heap_)
+            heap_.resize(n);
+    }
+
+    void clear() { truncate(0); }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T *begin() { return on_heap_ ? heap_.data() : inline_; }
+    T *end() { return begin() + size_; }
+    const T *begin() const { return on_heap_ ? heap_.data() : inline_; }
+    const T *end() const { return begin() + size_; }
+
+    T &operator[](size_t i) { return begin()[i]; }
+    const T &operator[](size_t i) const { return begin()[i]; }
+
+private:
+    T inline_[N];
+    vector<T> heap_;
+    size_t size_ = 0;
+    bool on_heap_ = false;
+};
+
+}  // ns detail
+
+}  // ns fuzz
@@ -7,18 +7,38 @@ namespace fuzz {
 
 enum { not_set = -1 };
 
+/*
+ * Compares two strings and caches what it finds out about them. The
+ * results are returned as references into that cache, so they stay valid
+ * until the strings are changed or the matcher is destroyed.
+ */
 class string_matcher {
 public:
+    /* Keeps its own copies of s1 and s2. */
     explicit string_matcher(string s1, string s2)
-        : s1_(s1), s2_(s2) {}
+    {
+        set_strings(std::move(s1), std::move(s2));
+    }
 
-    void set_strings(const string s1, const string s2);
-    void set_string1(const string s1);
-    void set_string2(const string s2);
+    /* Only points at the strings, which have to outlive the matcher. */
+    string_matcher(const char *s1, size_t len1, const char *s2, size_t len2)
+    {
+        set_strings(s1, len1, s2, len2);
+    }
 
-    vector<LevMatchingBlock> get_matching_blocks();
-    vector<LevOpCode> get_opcodes();
-    vector<LevEditOp> get_editops();
+    void set_strings(string s1, string s2);
+    void set_strings(const char *s1, size_t len1, const char *s2, size_t len2);
+    void set_string1(string s1);
+    void set_string1(const char *s1, size_t len1);
+    void set_string2(string s2);
+    void set_string2(const char *s2, size_t len2);
+
+    string_view string1() const { return s1_.view(); }
+    string_view string2() const { return s2_.view(); }
+
+    const vector<LevMatchingBlock> &get_matching_blocks();
+    const vector<LevOpCode> &get_opcodes();
+    const vector<LevEditOp> &get_editops();
 
     double ratio();
     double real_quick_ratio();
@@ -26,7 +46,18 @@ public:
 protected:
 
 private:
-    string s1_, s2_;
+    /* One of the strings, either owned by the matcher or only pointed at. */
+    struct source {
+        string owned;
+        const char *data = nullptr;
+        size_t size = 0;
+
+        void own(string s) { owned = std::move(s); data = nullptr; }
+        void point(const char *s, size_t len) { owned.clear(); data = s; size = len; }
+        string_view view() const { return data ? string_view(data, size) : string_view(owned); }
+    };
+
+    source s1_, s2_;
     double ratio_ = not_set;
     int distance_ = not_set;
 
@@ -2,7 +2,7 @@
 
 #include "common.hpp"
 
-#include <algorithm>  // std::max_element()
+#include <algorithm>  // std::max()
 
 namespace fuzz {
 
@@ -20,19 +20,17 @@ string join(const vector<string> &v, const string &sep = " ");
 
 string full_process(string str);
 
-size_t min(size_t a, size_t b);
-
-#ifdef CPP17
+/*
+ * full_process() without allocating. Writes the processed form of str to
+ * out, which needs room for len chars and may be str itself, and returns
+ * the processed length.
+ */
+size_t full_process_into(const char *str, size_t len, char *out);
 
-template <typename First, typename ... T>
-decltype(auto) max(const First &f, const T & ... t)
-{
-    const First *retval = &f;
-    ( (retval = &std::max(*retval, t)), ... );
-    return *retval;
-}
+/* full_process() of str into buf, which is reused. Returns a view of buf. */
+string_view full_process_into(string_view str, string &buf);
 
-#else
+size_t min(size_t a, size_t b);
 
 /*
  * An "extension" of std::max() so that more than two arguments
@@ -43,16 +41,14 @@ decltype(auto) max(const First &f, const T & ... t)
  * NOTE: Can this be done when omitting first?
  */
 template <typename T, typename... Args>
-auto max(const T &first, const Args&... args)
+T max(const T &first, const Args&... args)
 {
-    std::vector<T> vec = {first, static_cast<T>(args)...};
-    auto max = std::max_element(vec.cbegin(), vec.cend());
+    T max = first;
+    ((max = std::max(max, static_cast<T>(args))), ...);
 
-    return *max;
+    return max;
 }
 
-#endif
-
 }  // utils utils
   
 }  // utils fuzz
@@ -10,11 +10,16 @@ using std::vector;
 
 namespace wrapper {
 
-double ratio(const string &str1, const string &str2);
+/*
+ * The strings are only read, never copied. Anything that converts to a
+ * string_view can be passed, including a (const char *, size_t) pair as
+ * {s, len}.
+ */
+double ratio(string_view str1, string_view str2);
 
-vector<LevMatchingBlock> get_matching_blocks(vector<LevOpCode> &v, string &s1, string &s2);
-vector<LevOpCode> get_opcodes(string &s1, string &s2);
-vector<LevOpCode> get_opcodes(vector<LevEditOp> &ops, string &s1, string &s2);
-vector<LevEditOp> get_editops(string &s1, string &s2);
+vector<LevMatchingBlock> get_matching_blocks(const vector<LevOpCode> &v, string_view s1, string_view s2);
+vector<LevOpCode> get_opcodes(string_view s1, string_view s2);
+vector<LevOpCode> get_opcodes(const vector<LevEditOp> &ops, string_view s1, string_view s2);
+vector<LevEditOp> get_editops(string_view s1, string_view s2);
 
 }  // ns diffutils
@@ -0,0 +1,182 @@
+#include "bitparallel.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace fuzz {
+
+namespace detail {
+
+static inline int popcount64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+    for (; x; x &= x - 1)
+        n++;
+    return n;
+#endif
+}
+
+void pattern_match_vector::assign(const char *s, size_t len)
+{
+    len_ = len;
+    blocks_ = (len + 63) / 64;
+    masks_.assign(256 * blocks_, 0);
+
+    for (size_t i = 0; i < len; i++) {
+        const auto ch = static_cast<unsigned char>(s[i]);
+        masks_[ch * blocks_ + i / 64] |= uint64_t(1) << (i % 64);
+    }
+}
+
+/*
+ * One 64 bit word of state per block of the pattern. A zero bit in S
+ * marks a position that is part of the current LCS, so the result is the
+ * number of zero bits once all of s2 has been consumed.
+ */
+static size_t lcs_single_block(const uint64_t *masks, const char *s2, size_t len2)
+{
+    uint64_t S = ~uint64_t(0);
+    for (size_t j = 0; j < len2; j++) {
+        const uint64_t M = masks[static_cast<unsigned char>(s2[j])];
+        const uint64_t U = S & M;
+        S = (S + U) | (S - U);
+    }
+    return static_cast<size_t>(popcount64(~S));
+}
+
+size_t lcs_length(const pattern_match_vector &pm, const char *s2, size_t len2)
+{
+    const size_t blocks = pm.block_count();
+    if (blocks == 0 || len2 == 0)
+        return 0;
+
+    if (blocks == 1)
+        return lcs_single_block(pm.data(), s2, len2);
+
+    vector<uint64_t> S(blocks, ~uint64_t(0));
+    for (size_t j = 0; j < len2; j++) {
+        const auto ch = static_cast<unsigned char>(s2[j]);
+        uint64_t carry = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            const uint64_t M = pm.get(b, ch);
+            const uint64_t Sb = S[b];
+            const uint64_t U = Sb & M;
+            /* Sb + U + carry, keeping the carry for the next block */
+            const uint64_t sum1 = Sb + U;
+            const uint64_t sum = sum1 + carry;
+            carry = (sum1 < Sb) | (sum < sum1);
+            S[b] = sum | (Sb - U);
+        }
+    }
+
+    size_t lcs = 0;
+    for (size_t b = 0; b < blocks; b++)
+        lcs += static_cast<size_t>(popcount64(~S[b]));
+    return lcs;
+}
+
+size_t lcs_length(const char *s1, size_t len1, const char *s2, size_t len2)
+{
+    /* the pattern should be the shorter string, it needs fewer blocks */
+    if (len1 > len2) {
+        std::swap(s1, s2);
+        std::swap(len1, len2);
+    }
+    if (len1 == 0)
+        return 0;
+
+    if (len1 <= 64) {
+        uint64_t masks[256];
+        std::memset(masks, 0, sizeof(masks));
+        for (size_t i = 0; i < len1; i++)
+            masks[static_cast<unsigned char>(s1[i])] |= uint64_t(1) << i;
+        return lcs_single_block(masks, s2, len2);
+    }
+
+    return lcs_length(pattern_match_vector(s1, len1), s2, len2);
+}
+
+unsigned int lcs_ratio(size_t lcs, size_t len1, size_t len2)
+{
+    const size_t lensum = len1 + len2;
+    if (lensum == 0)
+        return 0;
+
+    const size_t dist = lensum - 2 * lcs;
+    return utils::percent_round(static_cast<double>(lensum - dist) / static_cast<double>(lensum));
+}
+
+unsigned int partial_lcs_ratio(const char *s1, size_t len1, const char *s2, size_t len2,
+                               unsigned int score_cutoff)
+{
+    if (len1 == 0 || len1 > len2 || score_cutoff > 100)
+        return 0;
+
+    /*
+     * How often each byte occurs in s1 and in the current window, and how
+     * many characters the window could match at most given those counts.
+     */
+    size_t count1[256] = {}, window[256] = {};
+    for (size_t i = 0; i < len1; i++)
+        count1[static_cast<unsigned char>(s1[i])]++;
+
+    auto add = [&](char c, size_t &common) {
+        const auto ch = static_cast<unsigned char>(c);
+        if (window[ch]++ < count1[ch])
+            common++;
+    };
+    auto remove = [&](char c, size_t &common) {
+        const auto ch = static_cast<unsigned char>(c);
+        if (--window[ch] < count1[ch])
+            common--;
+    };
+
+    /*
+     * No window can match more characters than all of s2 does, and the best
+     * a window could do with that is to be exactly those characters.
+     */
+    size_t common = 0;
+    for (size_t i = 0; i < len2; i++)
+        add(s2[i], common);
+    if (lcs_ratio(common, len1, common) < score_cutoff)
+        return 0;
+
+    std::memset(window, 0, sizeof(window));
+    common = 0;
+    for (size_t i = 0; i < len1; i++)
+        add(s2[i], common);
+
+    const pattern_match_vector pm(s1, len1);
+    unsigned int best = 0;
+
+    for (size_t start = 0; start < len2; start++) {
+        if (start > 0) {
+            remove(s2[start - 1], common);
+            if (start + len1 - 1 < len2)
+                add(s2[start + len1 - 1], common);
+        }
+
+        const size_t len = std::min(len1, len2 - start);
+        const unsigned int need = std::max(score_cutoff, best + 1);
+        if (lcs_ratio(common, len1, len) < need)
+            continue;
+
+        const unsigned int r = lcs_ratio(lcs_length(pm, s2 + start, len), len1, len);
+        if (r >= need) {
+            best = r;
+            if (best == 100)
+                break;
+        }
+    }
+
+    return best >= score_cutoff ? best : 0;
+}
+
+}  // ns detail
+
+}  // ns fuzz
@@ -1,99 +1,188 @@
 #include <iostream>
-#include <set>
+#include <cctype>
 #include <cmath>
 
 #include "fuzzywuzzy.hpp"
-#include "string_matcher.hpp"
 #include "utils.hpp"
+#include "bitparallel.hpp"
+#include "small_vector.hpp"
 
 namespace fuzz {
 
-unsigned int ratio(const string &s1, const string &s2, const bool full_process)
+/* Returns score, or 0 if it is below score_cutoff. */
+static unsigned int apply_cutoff(unsigned int score, const unsigned int score_cutoff)
 {
-    string p1 = full_process ? utils::full_process(s1) : s1;
-    string p2 = full_process ? utils::full_process(s2) : s2;
+    return score >= score_cutoff ? score : 0;
+}
 
-    auto m = string_matcher(p1, p2);
-    return utils::percent_round(m.ratio());
+/*
+ * The best ratio two strings of these lengths could have, i.e. when the
+ * shorter one is a subsequence of the longer one.
+ */
+static unsigned int max_ratio(size_t len1, size_t len2)
+{
+    return detail::lcs_ratio(utils::min(len1, len2), len1, len2);
 }
 
-unsigned int partial_ratio(const string &s1, const string &s2, const bool full_process)
+/*
+ * Strings the scorers build while scoring. Kept per thread and reused,
+ * so they stop allocating once they have grown large enough.
+ */
+struct scorer_scratch {
+    string processed1, processed2;
+    string sorted1, sorted2;
+    string combined;
+};
+
+static scorer_scratch &scratch()
 {
-    string p1 = full_process ? utils::full_process(s1) : s1;
-    string p2 = full_process ? utils::full_process(s2) : s2;
+    static thread_local scorer_scratch buffers;
+    return buffers;
+}
 
-    string shorter, longer;
+/* utils::full_process(s), built in buf. */
+static string_view process_into(string_view s, string &buf)
+{
+    return utils::full_process_into(s, buf);
+}
 
-    if (p1.length() <= p2.length()) {
-        shorter = p1;
-        longer  = p2;
-    } else {
-        shorter = p2;
-        longer  = p1;
-    }
+/* ratio() of two already processed strings. */
+static unsigned int processed_ratio(string_view s1, string_view s2, const unsigned int score_cutoff)
+{
+    if (max_ratio(s1.size(), s2.size()) < score_cutoff)
+        return 0;
 
-    auto m = string_matcher(shorter, longer);
-    auto blocks = m.get_matching_blocks();
-
-    /*
-     * Each block represents a string of matching characters
-     * in a string of the form (idx_1, idx_2, len). The best
-     * partial match will block align with at least one
-     * of those blocks.
-     * e.g. shorter = "abcd", longer "XXXbcdeEEE"
-     * block = (1, 3, 3)
-     * best score == ratio("abcd", "Xbcd")
-     */
-    vector<double> scores;
-    for (const auto &block : blocks) {
-        size_t long_start = utils::max(0, block.dpos - block.spos);
-        size_t long_end   = long_start + shorter.length();
-
-        auto long_substr = longer.substr(long_start, long_end);
-        auto m2 = string_matcher(shorter, long_substr);
-        double r = m2.ratio();
-
-        if (r > 0.995)
-            return 100;
-        else
-            scores.push_back(r);
-    }
+    size_t lcs = detail::lcs_length(s1.data(), s1.size(), s2.data(), s2.size());
+    return apply_cutoff(detail::lcs_ratio(lcs, s1.size(), s2.size()), score_cutoff);
+}
+
+/* partial_ratio() of two already processed strings. */
+static unsigned int processed_partial_ratio(string_view s1, string_view s2, const unsigned int score_cutoff)
+{
+    if (s1.length() > s2.length())
+        std::swap(s1, s2);
+
+    return detail::partial_lcs_ratio(s1.data(), s1.length(), s2.data(), s2.length(), score_cutoff);
+}
+
+unsigned int ratio(string_view s1, string_view s2, const bool full_process,
+                   const unsigned int score_cutoff)
+{
+    auto &buf = scratch();
+    string_view p1 = full_process ? process_into(s1, buf.processed1) : s1;
+    string_view p2 = full_process ? process_into(s2, buf.processed2) : s2;
+
+    return processed_ratio(p1, p2, score_cutoff);
+}
 
-    if (scores.empty())
+/*
+ * The best ratio of the shorter string against any part of the longer
+ * one as long as itself, see detail::partial_lcs_ratio().
+ */
+unsigned int partial_ratio(string_view s1, string_view s2, const bool full_process,
+                           const unsigned int score_cutoff)
+{
+    if (score_cutoff > 100)
         return 0;
 
-    double max = *std::max_element(scores.cbegin(), scores.cend());
-    return utils::percent_round(max);
+    auto &buf = scratch();
+    string_view p1 = full_process ? process_into(s1, buf.processed1) : s1;
+    string_view p2 = full_process ? process_into(s2, buf.processed2) : s2;
+
+    return processed_partial_ratio(p1, p2, score_cutoff);
 }
 
-/* Returns a cleaned string with tokens sorted. */
-static string proccess_and_sort(const string &s, const bool full_process)
+/*
+ * The token scorers work on string_view tokens in small_vectors, which
+ * stay on the stack for up to this many tokens.
+ */
+using token_list = detail::small_vector<string_view, 32>;
+
+/* utils::trim() without copying. */
+static string_view trim(string_view s)
 {
-    string ps = (full_process ? utils::full_process(s) : s);
+    size_t start = 0, end = s.size();
+    while (start < end && std::isspace(s[start]))
+        start++;
+    while (end > start && std::isspace(s[end - 1]))
+        end--;
+    return s.substr(start, end - start);
+}
+
+/* The same tokens utils::split_string() returns, as views into s. */
+static void split_tokens(string_view s, token_list &tokens)
+{
+    size_t start = 0;
+    for (size_t i = 0; i <= s.size(); i++) {
+        if (i == s.size() || s[i] == ' ') {
+            if (i > start)
+                tokens.push_back(s.substr(start, i - start));
+            start = i + 1;
+        }
+    }
+}
 
-    auto tokens = utils::split_string(ps);
+/* Sorted tokens of s without duplicates. */
+static void token_set(string_view s, token_list &tokens)
+{
+    split_tokens(s, tokens);
     std::sort(tokens.begin(), tokens.end());
-    string sorted = utils::join(tokens);
+    tokens.truncate(std::unique(tokens.begin(), tokens.end()) - tokens.begin());
+}
 
-    return utils::trim(sorted);
+/* Appends the tokens to buf, separated by spaces, like utils::join(). */
+static void append_joined(string &buf, const token_list &tokens)
+{
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (i > 0)
+            buf += ' ';
+        buf.append(tokens[i].data(), tokens[i].size());
+    }
 }
 
-unsigned int token_sort_ratio(const string &s1, const string &s2, const bool full_proccess)
+/*
+ * The string token_sort_ratio() compares: s processed (if full_process),
+ * its tokens sorted and joined, and the result processed once more since
+ * ratio() does that. Built in sorted, the returned view points into it.
+ */
+static string_view sort_tokens(string_view s, const bool full_process, string &processed, string &sorted)
+{
+    if (full_process)
+        s = process_into(s, processed);
+
+    token_list tokens;
+    split_tokens(s, tokens);
+    std::sort(tokens.begin(), tokens.end());
+
+    sorted.clear();
+    append_joined(sorted, tokens);
+
+    /* Joined processed tokens are already processed. */
+    if (!full_process)
+        sorted = utils::full_process(std::move(sorted));
+    return sorted;
+}
+
+unsigned int token_sort_ratio(string_view s1, string_view s2, const bool full_proccess,
+                              const unsigned int score_cutoff)
 {
     /* NOTE: do we need force_ascii? */
-    string sorted1 = proccess_and_sort(s1, full_proccess);
-    string sorted2 = proccess_and_sort(s2, full_proccess);
+    auto &buf = scratch();
+    string_view sorted1 = sort_tokens(s1, full_proccess, buf.processed1, buf.sorted1);
+    string_view sorted2 = sort_tokens(s2, full_proccess, buf.processed2, buf.sorted2);
 
-    return ratio(sorted1, sorted2);
+    return processed_ratio(sorted1, sorted2, score_cutoff);
 }
 
-unsigned int token_sort_partial_ratio(const string &s1, const string &s2, const bool full_proccess)
+unsigned int token_sort_partial_ratio(string_view s1, string_view s2, const bool full_proccess,
+                                      const unsigned int score_cutoff)
 {
     /* NOTE: do we need force_ascii? */
-    string sorted1 = proccess_and_sort(s1, full_proccess);
-    string sorted2 = proccess_and_sort(s2, full_proccess);
+    auto &buf = scratch();
+    string_view sorted1 = sort_tokens(s1, full_proccess, buf.processed1, buf.sorted1);
+    string_view sorted2 = sort_tokens(s2, full_proccess, buf.processed2, buf.sorted2);
 
-    return partial_ratio(sorted1, sorted2);
+    return processed_partial_ratio(sorted1, sorted2, score_cutoff);
 }
 
 /*
@@ -102,82 +191,174 @@ unsigned int token_sort_partial_ratio(const string &s1, const string &s2, const
  *  - construct two strings of the form <sorted_intersection><sorted_remainder>,
  *  - take ratios of those two strings, and
  *  - check for unordered partial matches.
+ *
+ * tokens1 and tokens2 come from token_set(). The strings are processed
+ * already if they need to be, joining processed tokens keeps them that way.
  */
-static unsigned int token_set_ratio(const string &s1, const string &s2, bool partial, const bool full_process)
+static unsigned int token_set_ratio(const token_list &tokens1, const token_list &tokens2,
+                                    bool partial, const unsigned int score_cutoff)
 {
-    string p1 = full_process ? utils::full_process(s1) : s1;
-    string p2 = full_process ? utils::full_process(s2) : s2;
-
-    if (p1.length() == 0 || p2.length() == 0)
+    if (score_cutoff > 100)
         return 0;
 
-    auto split1 = utils::split_string(p1), split2 = utils::split_string(p2);
-    auto tokens1 = std::set<string>(split1.cbegin(), split1.cend()),
-         tokens2 = std::set<string>(split2.cbegin(), split2.cend());
+    /* Both lists are sorted, so one merge finds the intersection and both differences. */
+    token_list intersection, diff1to2, diff2to1;
+    size_t i = 0, j = 0;
+    while (i < tokens1.size() && j < tokens2.size()) {
+        if (tokens1[i] < tokens2[j]) {
+            diff1to2.push_back(tokens1[i++]);
+        } else if (tokens2[j] < tokens1[i]) {
+            diff2to1.push_back(tokens2[j++]);
+        } else {
+            intersection.push_back(tokens1[i++]);
+            j++;
+        }
+    }
+    for (; i < tokens1.size(); i++)
+        diff1to2.push_back(tokens1[i]);
+    for (; j < tokens2.size(); j++)
+        diff2to1.push_back(tokens2[j]);
+
+    /* Both combined strings go into one buffer: <sect> <1to2><sect> <2to1> */
+    string &buf = scratch().combined;
+    buf.clear();
+    append_joined(buf, intersection);
+    const size_t sect_len = buf.size();
+    buf += ' ';
+    append_joined(buf, diff1to2);
+    const size_t combined_1to2_len = buf.size();
+    buf.append(buf, 0, sect_len + 1);
+    append_joined(buf, diff2to1);
+
+    const string_view all = buf;
+    const string_view sorted_sect = trim(all.substr(0, sect_len)),
+                      combined_1to2 = trim(all.substr(0, combined_1to2_len)),
+                      combined_2to1 = trim(all.substr(combined_1to2_len));
+
+    /* One set of tokens contains the other, so one combined string equals sorted_sect. */
+    if (!sorted_sect.empty() && (diff1to2.empty() || diff2to1.empty()))
+        return 100;
+
+    /* Each comparison only has to beat the best one so far. */
+    auto ratio_func = [partial](string_view a, string_view b, const unsigned int cutoff) {
+        return partial ? processed_partial_ratio(a, b, cutoff) : processed_ratio(a, b, cutoff);
+    };
+    unsigned int best = 0;
+    best = std::max(best, ratio_func(sorted_sect, combined_1to2, std::max(score_cutoff, best + 1)));
+    best = std::max(best, ratio_func(sorted_sect, combined_2to1, std::max(score_cutoff, best + 1)));
+    best = std::max(best, ratio_func(combined_1to2, combined_2to1, std::max(score_cutoff, best + 1)));
 
-    vector<string> intersection, diff1to2, diff2to1;
+    return apply_cutoff(best, score_cutoff);
+}
 
-    std::set_intersection(tokens1.cbegin(), tokens1.cend(),
-                          tokens2.cbegin(), tokens2.cend(),
-                          std::back_inserter(intersection));
+static unsigned int token_set_ratio(string_view s1, string_view s2, bool partial, const bool full_process,
+                                    const unsigned int score_cutoff)
+{
+    auto &buf = scratch();
+    string_view p1 = full_process ? process_into(s1, buf.processed1) : s1;
+    string_view p2 = full_process ? process_into(s2, buf.processed2) : s2;
 
-    std::set_difference(tokens1.cbegin(), tokens1.cend(),
-                        tokens2.cbegin(), tokens2.cend(),
-                        std::back_inserter(diff1to2));
-    std::set_difference(tokens2.cbegin(), tokens2.cend(),
-                        tokens1.cbegin(), tokens1.cend(),
-                        std::back_inserter(diff2to1));
+    if (p1.length() == 0 || p2.length() == 0)
+        return 0;
 
-    std::sort(intersection.begin(), intersection.end());
-    std::sort(diff1to2.begin(), diff1to2.end());
-    std::sort(diff2to1.begin(), diff2to1.end());
+    token_list tokens1, tokens2;
+    token_set(p1, tokens1);
+    token_set(p2, tokens2);
+    return token_set_ratio(tokens1, tokens2, partial, score_cutoff);
+}
 
-    auto sorted_sect = utils::join(intersection),
-         sorted_1to2 = utils::join(diff1to2),
-         sorted_2to1 = utils::join(diff2to1);
+unsigned int token_set_ratio(string_view s1, string_view s2, const bool full_process,
+                             const unsigned int score_cutoff)
+{
+    return token_set_ratio(s1, s2, false, full_process, score_cutoff);
+}
 
-    auto combined_1to2 = sorted_sect + " " + sorted_1to2,
-         combined_2to1 = sorted_sect + " " + sorted_2to1;
+unsigned int partial_token_set_ratio(string_view s1, string_view s2, const bool full_process,
+                                     const unsigned int score_cutoff)
+{
+    return token_set_ratio(s1, s2, true, full_process, score_cutoff);
+}
 
-    sorted_sect = utils::trim(sorted_sect);
-    combined_1to2 = utils::trim(combined_1to2);
-    combined_2to1 = utils::trim(combined_2to1);
+unsigned int quick_ratio(string_view s1, string_view s2, const bool full_process,
+                         const unsigned int score_cutoff)
+{
+    auto &buf = scratch();
+    string_view p1 = full_process ? process_into(s1, buf.processed1) : s1;
+    string_view p2 = full_process ? process_into(s2, buf.processed2) : s2;
 
-    auto ratio_func = partial ? partial_ratio : ratio;
-    auto pairwise = vector<unsigned int>{
-        ratio_func(sorted_sect, combined_1to2, full_process),
-        ratio_func(sorted_sect, combined_2to1, full_process),
-        ratio_func(combined_1to2, combined_2to1, full_process)
-    };
+    if (p1.length() == 0 || p2.length() == 0)
+        return 0;
 
-    return *std::max_element(pairwise.cbegin(), pairwise.cend());
+    /* ratio() processes its inputs, which only changes them if they weren't processed here. */
+    return full_process ? processed_ratio(p1, p2, score_cutoff) : ratio(p1, p2, true, score_cutoff);
 }
 
-unsigned int token_set_ratio(const string &s1, const string &s2, const bool full_process)
+/*
+ * weighted_ratio() keeps the best of several scaled scores, truncated to
+ * an integer. For a sub-scorer whose result gets multiplied by scale (and
+ * which can reach at most max_scaled that way), finds the cutoff it has to
+ * be called with so it can still produce need. Returns false if even a
+ * perfect score would fall short, so the sub-scorer can be skipped.
+ */
+static bool scaled_cutoff(double max_scaled, double scale, unsigned int need, unsigned int &cutoff)
 {
-    return token_set_ratio(s1, s2, false, full_process);
+    if (static_cast<unsigned int>(max_scaled) < need)
+        return false;
+
+    /* Rounded down with a point to spare, a cutoff that is too low is only slower. */
+    double min_score = std::floor(need / scale);
+    cutoff = min_score >= 1 ? static_cast<unsigned int>(min_score) - 1 : 0;
+    return true;
 }
 
-unsigned int partial_token_set_ratio(const string &s1, const string &s2, const bool full_process)
+/* The ratio between the string behind pm and s2. */
+static unsigned int ratio(const detail::pattern_match_vector &pm, string_view s2, const unsigned int score_cutoff)
 {
-    return token_set_ratio(s1, s2, true, full_process);
+    if (max_ratio(pm.size(), s2.length()) < score_cutoff)
+        return 0;
+
+    size_t lcs = detail::lcs_length(pm, s2.data(), s2.length());
+    return apply_cutoff(detail::lcs_ratio(lcs, pm.size(), s2.length()), score_cutoff);
 }
 
-unsigned int quick_ratio(const string &s1, const string &s2, const bool full_process)
+/*
+ * One side of weighted_ratio(): the processed string, its sorted tokens
+ * joined back together and the same tokens without duplicates. Each is
+ * built once and shared by all the sub-scorers.
+ */
+struct weighted_input {
+    string_view processed;
+    string_view sorted;
+    token_list tokens;
+};
+
+/* Fills in from s, processing it first if full_process. The views point into s, processed and sorted. */
+static void prepare_weighted(string_view s, const bool full_process, string &processed, string &sorted,
+                             weighted_input &in)
 {
-    string p1 = full_process ? utils::full_process(s1) : s1;
-    string p2 = full_process ? utils::full_process(s2) : s2;
+    in.processed = full_process ? process_into(s, processed) : s;
 
-    if (p1.length() == 0 || p2.length() == 0)
-        return 0;
+    split_tokens(in.processed, in.tokens);
+    std::sort(in.tokens.begin(), in.tokens.end());
+
+    sorted.clear();
+    append_joined(sorted, in.tokens);
+    in.sorted = sorted;
 
-    return ratio(p1, p2);
+    in.tokens.truncate(std::unique(in.tokens.begin(), in.tokens.end()) - in.tokens.begin());
 }
 
-unsigned int weighted_ratio(const string &s1, const string &s2, const bool full_process)
+/*
+ * The steps of weighted_ratio() once both sides are prepared. pm1 and
+ * sorted_pm1 are the bit masks of in1's processed and sorted strings if
+ * the caller has them ready, or null.
+ */
+static unsigned int weighted_ratio(const weighted_input &in1, const weighted_input &in2,
+                                   const detail::pattern_match_vector *pm1,
+                                   const detail::pattern_match_vector *sorted_pm1,
+                                   const unsigned int score_cutoff)
 {
-    string p1 = full_process ? utils::full_process(s1) : s1;
-    string p2 = full_process ? utils::full_process(s2) : s2;
+    const string_view p1 = in1.processed, p2 = in2.processed;
 
     if (p1.length() == 0 || p2.length() == 0)
         return 0;
@@ -186,7 +367,7 @@ unsigned int weighted_ratio(const string &s1, const string &s2, const bool full_
     double unbase_scale = 0.95;
     double partial_scale = 0.90;
 
-    auto base = ratio(p1, p2);
+    auto base = pm1 ? ratio(*pm1, p2, score_cutoff) : processed_ratio(p1, p2, score_cutoff);
     double len_ratio = static_cast<double>(utils::max(p1.length(), p2.length())) /
             static_cast<double>(utils::min(p1.length(), p2.length()));
 
@@ -198,18 +379,115 @@ unsigned int weighted_ratio(const string &s1, const string &s2, const bool full_
     if (len_ratio > 8)
         partial_scale = 0.60;
 
-    if (try_partial) {
-        double partial = partial_ratio(p1, p2) * partial_scale;
-        double ptsor = token_sort_partial_ratio(p1, p2) * unbase_scale * partial_scale;
-        double ptser = partial_token_set_ratio(p1, p2) * unbase_scale * partial_scale;
+    /* Sub-scorers are only run if their scaled result can still beat best. */
+    unsigned int best = base, cutoff;
 
-        return utils::intr(utils::max(base, partial, ptsor, ptser));
+    if (try_partial) {
+        double partial = 0, ptsor = 0, ptser = 0;
+
+        if (scaled_cutoff(100 * partial_scale, partial_scale, std::max(score_cutoff, best + 1), cutoff)) {
+            partial = processed_partial_ratio(p1, p2, cutoff) * partial_scale;
+            best = utils::max(best, partial);
+        }
+        if (scaled_cutoff(100 * unbase_scale * partial_scale, unbase_scale * partial_scale,
+                          std::max(score_cutoff, best + 1), cutoff)) {
+            ptsor = processed_partial_ratio(in1.sorted, in2.sorted, cutoff) * unbase_scale * partial_scale;
+            best = utils::max(best, ptsor);
+        }
+        if (scaled_cutoff(100 * unbase_scale * partial_scale, unbase_scale * partial_scale,
+                          std::max(score_cutoff, best + 1), cutoff)) {
+            ptser = token_set_ratio(in1.tokens, in2.tokens, true, cutoff) * unbase_scale * partial_scale;
+        }
+
+        return apply_cutoff(utils::intr(utils::max(base, partial, ptsor, ptser)), score_cutoff);
     } else {
-        double tsor = token_sort_ratio(p1, p2, false) * unbase_scale;
-        double tser = token_set_ratio(p1, p2, false) * unbase_scale;
-
-        return utils::intr(utils::max(base, tsor, tser));
+        double tsor = 0, tser = 0;
+
+        if (scaled_cutoff(100 * unbase_scale, unbase_scale, std::max(score_cutoff, best + 1), cutoff)) {
+            tsor = (sorted_pm1 ? ratio(*sorted_pm1, in2.sorted, cutoff) : processed_ratio(in1.sorted, in2.sorted, cutoff))
+                   * unbase_scale;
+            best = utils::max(best, tsor);
+        }
+        if (scaled_cutoff(100 * unbase_scale, unbase_scale, std::max(score_cutoff, best + 1), cutoff)) {
+            tser = token_set_ratio(in1.tokens, in2.tokens, false, cutoff) * unbase_scale;
+        }
+
+        return apply_cutoff(utils::intr(utils::max(base, tsor, tser)), score_cutoff);
     }
 }
 
+unsigned int weighted_ratio(string_view s1, string_view s2, const bool full_process,
+                            const unsigned int score_cutoff)
+{
+    auto &buf = scratch();
+    weighted_input in1, in2;
+    prepare_weighted(s1, full_process, buf.processed1, buf.sorted1, in1);
+    prepare_weighted(s2, full_process, buf.processed2, buf.sorted2, in2);
+
+    return weighted_ratio(in1, in2, nullptr, nullptr, score_cutoff);
+}
+
+cached_ratio::cached_ratio(string_view s1, const bool full_process)
+    : full_process_(full_process), s1_(s1)
+{
+    if (full_process_)
+        s1_ = utils::full_process(std::move(s1_));
+
+    pm_.assign(s1_.data(), s1_.length());
+}
+
+unsigned int cached_ratio::score(string_view s2, const unsigned int score_cutoff) const
+{
+    if (full_process_)
+        return ratio(pm_, process_into(s2, scratch().processed2), score_cutoff);
+
+    return ratio(pm_, s2, score_cutoff);
+}
+
+cached_token_sort_ratio::cached_token_sort_ratio(string_view s1, const bool full_process)
+    : full_process_(full_process)
+{
+    string processed, sorted;
+    sorted1_ = string(sort_tokens(s1, full_process, processed, sorted));
+    pm_.assign(sorted1_.data(), sorted1_.length());
+}
+
+unsigned int cached_token_sort_ratio::score(string_view s2, const unsigned int score_cutoff) const
+{
+    auto &buf = scratch();
+    string_view sorted2 = sort_tokens(s2, full_process_, buf.processed2, buf.sorted2);
+
+    return ratio(pm_, sorted2, score_cutoff);
+}
+
+cached_weighted_ratio::cached_weighted_ratio(string_view s1, const bool full_process)
+    : full_process_(full_process)
+{
+    string processed, sorted;
+    weighted_input in;
+    prepare_weighted(s1, full_process, processed, sorted, in);
+
+    s1_ = string(in.processed.data(), in.processed.size());
+    sorted1_ = sorted;
+    for (const auto &token : in.tokens)
+        tokens1_.emplace_back(token.data(), token.size());
+
+    pm_.assign(s1_.data(), s1_.length());
+    sorted_pm_.assign(sorted1_.data(), sorted1_.length());
+}
+
+unsigned int cached_weighted_ratio::score(string_view s2, const unsigned int score_cutoff) const
+{
+    weighted_input in1, in2;
+    in1.processed = s1_;
+    in1.sorted = sorted1_;
+    for (const auto &token : tokens1_)
+        in1.tokens.push_back(token);
+
+    auto &buf = scratch();
+    prepare_weighted(s2, full_process_, buf.processed2, buf.sorted2, in2);
+
+    return weighted_ratio(in1, in2, &pm_, &sorted_pm_, score_cutoff);
+}
+
 }  // ns fuzz
@@ -102,6 +102,7 @@
 #  define _GNU_SOURCE
 #endif
 
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
 /* for debugging */
@@ -110,6 +111,88 @@
 #include <assert.h>
 #include "levenshtein.h"
 
+/**
+ * lev_scratch_init:
+ * @scratch: The scratch context to initialize.
+ *
+ * Prepares an empty scratch context for the _ex functions.  Nothing is
+ * allocated until a buffer is first needed.
+ **/
+void
+lev_scratch_init(LevScratch *scratch)
+{
+    memset(scratch->buf, 0, sizeof(scratch->buf));
+    memset(scratch->size, 0, sizeof(scratch->size));
+}
+
+/**
+ * lev_scratch_free:
+ * @scratch: The scratch context to release.
+ *
+ * Frees all buffers of @scratch, it's empty (and usable) afterwards.
+ **/
+void
+lev_scratch_free(LevScratch *scratch)
+{
+    size_t i;
+
+    for (i = 0; i < LEV_SCRATCH_LAST; i++)
+        free(scratch->buf[i]);
+    lev_scratch_init(scratch);
+}
+
+/**
+ * scratch_get:
+ * @scratch: A scratch context, or NULL to allocate from the heap.
+ * @slot: Which of the context's buffers to use.
+ * @bytes: The size needed.
+ *
+ * Without a context this is malloc().  With one, the buffer of @slot is
+ * grown if necessary and returned, its previous contents are lost.  Small
+ * work areas come from the context itself.
+ *
+ * Returns: The buffer, or NULL when out of memory.
+ **/
+static void*
+scratch_get(LevScratch *scratch, LevScratchSlot slot, size_t bytes)
+{
+    size_t size;
+
+    if (!scratch)
+        return malloc(bytes);
+
+    if (slot == LEV_SCRATCH_WORK && bytes <= sizeof(scratch->small))
+        return scratch->small;
+
+    if (scratch->size[slot] < bytes || !scratch->buf[slot]) {
+        /* grow geometrically so a slowly growing input doesn't realloc
+         * on every call */
+        size = scratch->size[slot] * 2;
+        if (size < bytes)
+            size = bytes;
+        if (size == 0)
+            size = 1;
+        free(scratch->buf[slot]);
+        scratch->buf[slot] = malloc(size);
+        scratch->size[slot] = scratch->buf[slot] ? size : 0;
+    }
+    return scratch->buf[slot];
+}
+
+/**
+ * scratch_put:
+ * @scratch: The context @ptr was taken from, or NULL.
+ * @ptr: A buffer returned by scratch_get().
+ *
+ * Gives a buffer back, which only frees it when it came from the heap.
+ **/
+static void
+scratch_put(LevScratch *scratch, void *ptr)
+{
+    if (!scratch)
+        free(ptr);
+}
+
 /**
  * lev_edit_distance:
  * @len1: The length of @string1.
@@ -127,6 +210,27 @@ size_t
 lev_edit_distance(size_t len1, const lev_byte *string1,
                   size_t len2, const lev_byte *string2,
                   int xcost) {
+    return lev_edit_distance_ex(len1, string1, len2, string2, xcost, NULL);
+}
+
+/**
+ * lev_edit_distance_ex:
+ * @len1: The length of @string1.
+ * @string1: A sequence of bytes of length @len1, may contain NUL characters.
+ * @len2: The length of @string2.
+ * @string2: A sequence of bytes of length @len2, may contain NUL characters.
+ * @xcost: If nonzero, the replace operation has weight 2, otherwise all
+ *         edit operations have equal weights of 1.
+ * @scratch: Where to take the cost row from, or NULL to allocate it.
+ *
+ * lev_edit_distance() with a reusable scratch context.
+ *
+ * Returns: The edit distance.
+ **/
+size_t
+lev_edit_distance_ex(size_t len1, const lev_byte *string1,
+                     size_t len2, const lev_byte *string2,
+                     int xcost, LevScratch *scratch) {
     size_t i;
     size_t *row;  /* we only need to keep one row of costs */
     size_t *end;
@@ -173,7 +277,7 @@ lev_edit_distance(size_t len1, const lev_byte *string1,
     half = len1 >> 1;
 
     /* initialize first row */
-    row = (size_t *) malloc(len2 * sizeof(size_t));
+    row = (size_t *) scratch_get(scratch, LEV_SCRATCH_WORK, len2 * sizeof(size_t));
     if (!row)
         return (size_t) (-1);
     end = row + len2 - 1;
@@ -259,114 +363,389 @@ lev_edit_distance(size_t len1, const lev_byte *string1,
     }
 
     i = *end;
-    free(row);
+    scratch_put(scratch, row);
     return i;
 }
 
+/* A cell of the stored cost matrix.  Only the low 16 bits of each cost are
+ * kept: the way back only compares neighbouring cells, which never differ
+ * by more than one, so the comparisons come out the same modulo 2^16. */
+typedef uint16_t lev_cell;
+
+/* (a - b) of two neighbouring cells, from their low 16 bits. */
+#define CELL_DIFF(a, b) ((lev_cell)((a) - (b)))
+
+/* The stored part of the cost matrix is kept below this many cells, longer
+ * inputs are stored a block of rows at a time (see lev_editops_find_ex). */
+#define LEV_EDITOPS_BLOCK_CELLS ((size_t)1 << 22)
+
 /**
- * editops_from_cost_matrix:
- * @len1: The length of @string1.
- * @string1: A string of length @len1, may contain NUL characters.
- * @o1: The offset where the matrix starts from the start of @string1.
- * @len2: The length of @string2.
- * @string2: A string of length @len2, may contain NUL characters.
- * @o2: The offset where the matrix starts from the start of @string2.
- * @matrix: The cost matrix.
- * @n: Where the number of edit operations should be stored.
+ * cost_rows:
+ * @lo: The row @start holds.
+ * @hi: The last row to compute.
+ * @string1: The source string, row i compares its character i - 1.
+ * @len2: The length of a row.
+ * @string2: The destination string.
+ * @start: The costs of row @lo.
+ * @a: A work row of @len2 costs.
+ * @b: Another work row of @len2 costs.
+ * @block: Where to store rows @lo to @hi, or NULL.
  *
- * Reconstructs the optimal edit sequence from the cost matrix @matrix.
+ * Computes the rows of the cost matrix from @lo to @hi.
  *
- * The matrix is freed.
- *
- * Returns: The optimal edit sequence, as a newly allocated array of
- *          elementary edit operations, it length is stored in @n.
+ * Returns: Row @hi, which is either @a or @b.
  **/
-static LevEditOp*
-editops_from_cost_matrix(size_t len1, const lev_byte *string1, size_t off1,
-                         size_t len2, const lev_byte *string2, size_t off2,
-                         size_t *matrix, size_t *n)
+static size_t*
+cost_rows(size_t lo, size_t hi, const lev_byte *string1,
+          size_t len2, const lev_byte *string2,
+          const size_t *start, size_t *a, size_t *b, lev_cell *block)
 {
-    size_t *p;
-    size_t i, j, pos;
-    LevEditOp *ops;
-    int dir = 0;
+    size_t i, j;
+    size_t *prev = a, *row = b, *t;
 
-    pos = *n = matrix[len1*len2 - 1];
-    if (!*n) {
-        free(matrix);
-        return NULL;
+    memcpy(prev, start, len2*sizeof(size_t));
+    if (block) {
+        for (j = 0; j < len2; j++)
+            block[j] = (lev_cell)prev[j];
+        block += len2;
     }
-    ops = (LevEditOp*)malloc((*n)*sizeof(LevEditOp));
-    if (!ops) {
-        free(matrix);
-        *n = (size_t)(-1);
-        return NULL;
+
+    for (i = lo + 1; i <= hi; i++) {
+        const lev_byte char1 = string1[i - 1];
+        size_t x = i;
+        row[0] = x;
+        if (block)
+            block[0] = (lev_cell)x;
+        for (j = 1; j < len2; j++) {
+            size_t c3 = prev[j - 1] + (char1 != string2[j - 1]);
+            x++;
+            if (x > c3)
+                x = c3;
+            c3 = prev[j] + 1;
+            if (x > c3)
+                x = c3;
+            row[j] = x;
+            if (block)
+                block[j] = (lev_cell)x;
+        }
+        if (block)
+            block += len2;
+        t = prev;
+        prev = row;
+        row = t;
     }
-    i = len1 - 1;
-    j = len2 - 1;
-    p = matrix + len1*len2 - 1;
-    while (i || j) {
+
+    return prev;
+}
+
+/**
+ * editops_from_cost_block:
+ * @string1: The source string, of the length the matrix has rows, minus one.
+ * @off1: The offset where the matrix starts from the start of @string1.
+ * @len2: The length of a matrix row.
+ * @string2: The destination string, of length @len2 - 1.
+ * @off2: The offset where the matrix starts from the start of @string2.
+ * @p: The cell at *@i, *@j.
+ * @up: How far the cell above is stored from a cell (the one to the left
+ *      is next to it, the diagonal one right before the one above).
+ * @lo: The first row stored.
+ * @i: The current row, updated.
+ * @j: The current column, updated.
+ * @dir: The current direction, updated.
+ * @pos: How many edit operations are still to be found.
+ * @ops: Where the edit operations go, filled backwards from @pos.
+ *
+ * Follows the optimal edit sequence back through the stored rows, until it
+ * reaches the start of the matrix or row @lo (which needs the block before
+ * it to go on).
+ *
+ * Returns: How many edit operations are still to be found.
+ **/
+static size_t
+editops_from_cost_block(const lev_byte *string1, size_t off1,
+                        const lev_byte *string2, size_t off2,
+                        const lev_cell *p, size_t up, size_t lo,
+                        size_t *i, size_t *j, int *dir,
+                        size_t pos, LevEditOp *ops)
+{
+
+    while ((*i || *j) && (*i > lo || lo == 0)) {
         /* prefer contiuning in the same direction */
-        if (dir < 0 && j && *p == *(p - 1) + 1) {
+        if (*dir < 0 && *j && CELL_DIFF(*p, *(p - 1)) == 1) {
             pos--;
             ops[pos].type = LEV_EDIT_INSERT;
-            ops[pos].spos = i + off1;
-            ops[pos].dpos = --j + off2;
+            ops[pos].spos = *i + off1;
+            ops[pos].dpos = --*j + off2;
             p--;
             continue;
         }
-        if (dir > 0 && i && *p == *(p - len2) + 1) {
+        if (*dir > 0 && *i && CELL_DIFF(*p, *(p - up)) == 1) {
             pos--;
             ops[pos].type = LEV_EDIT_DELETE;
-            ops[pos].spos = --i + off1;
-            ops[pos].dpos = j + off2;
-            p -= len2;
+            ops[pos].spos = --*i + off1;
+            ops[pos].dpos = *j + off2;
+            p -= up;
             continue;
         }
-        if (i && j && *p == *(p - len2 - 1)
-            && string1[i - 1] == string2[j - 1]) {
+        if (*i && *j && *p == *(p - up - 1)
+            && string1[*i - 1] == string2[*j - 1]) {
             /* don't be stupid like difflib, don't store LEV_EDIT_KEEP */
-            i--;
-            j--;
-            p -= len2 + 1;
-            dir = 0;
+            --*i;
+            --*j;
+            p -= up + 1;
+            *dir = 0;
             continue;
         }
-        if (i && j && *p == *(p - len2 - 1) + 1) {
+        if (*i && *j && CELL_DIFF(*p, *(p - up - 1)) == 1) {
             pos--;
             ops[pos].type = LEV_EDIT_REPLACE;
-            ops[pos].spos = --i + off1;
-            ops[pos].dpos = --j + off2;
-            p -= len2 + 1;
-            dir = 0;
+            ops[pos].spos = --*i + off1;
+            ops[pos].dpos = --*j + off2;
+            p -= up + 1;
+            *dir = 0;
             continue;
         }
         /* we cant't turn directly from -1 to 1, in this case it would be better
          * to go diagonally, but check it (dir == 0) */
-        if (dir == 0 && j && *p == *(p - 1) + 1) {
+        if (*dir == 0 && *j && CELL_DIFF(*p, *(p - 1)) == 1) {
             pos--;
             ops[pos].type = LEV_EDIT_INSERT;
-            ops[pos].spos = i + off1;
-            ops[pos].dpos = --j + off2;
+            ops[pos].spos = *i + off1;
+            ops[pos].dpos = --*j + off2;
             p--;
-            dir = -1;
+            *dir = -1;
             continue;
         }
-        if (dir == 0 && i && *p == *(p - len2) + 1) {
+        if (*dir == 0 && *i && CELL_DIFF(*p, *(p - up)) == 1) {
             pos--;
             ops[pos].type = LEV_EDIT_DELETE;
-            ops[pos].spos = --i + off1;
-            ops[pos].dpos = j + off2;
-            p -= len2;
-            dir = 1;
+            ops[pos].spos = --*i + off1;
+            ops[pos].dpos = *j + off2;
+            p -= up;
+            *dir = 1;
             continue;
         }
         /* coredump right now, later might be too late ;-) */
         assert("lost in the cost matrix" == NULL);
     }
-    free(matrix);
 
-    return ops;
+    return pos;
+}
+
+
+/**
+ * block_layout:
+ * @len1: The number of matrix rows.
+ * @len2: The number of matrix columns.
+ * @rows: Where the number of matrix rows per block should be stored.
+ * @nblocks: Where the number of blocks should be stored.
+ *
+ * Splits the matrix into the blocks of rows lev_editops_find_ex() stores.
+ * They are each small enough, but at least sqrt(@len1) rows, so there
+ * aren't too many of them.  Short inputs fit in a single block.
+ *
+ * Returns: The bytes of work area the blocks need.
+ **/
+static size_t
+block_layout(size_t len1, size_t len2, size_t *rows, size_t *nblocks)
+{
+    size_t i;
+
+    *rows = LEV_EDITOPS_BLOCK_CELLS / len2;
+    for (i = 1; i*i < len1; i++)
+        ;
+    if (*rows < i)
+        *rows = i;
+    if (*rows < 1)
+        *rows = 1;
+    *nblocks = len1 > 1 ? (len1 - 2) / *rows + 1 : 1;
+    if (*nblocks == 1)
+        *rows = len1 - 1;
+    return (*nblocks + 2)*len2*sizeof(size_t) + (*rows + 1)*len2*sizeof(lev_cell);
+}
+
+/* The narrowest band editops_find_banded() tries first, and how much of a
+ * row the band may cover before the full matrix is cheaper. */
+#define LEV_BAND_MIN 16
+#define LEV_BAND_MAX_FRACTION 4
+
+/**
+ * band_row:
+ * @i: The matrix row to compute.
+ * @string1: The source string.
+ * @len2: The number of matrix columns.
+ * @string2: The destination string.
+ * @k: How far off the diagonal the band reaches.
+ * @prev: Row @i - 1 of the band, unused when @i is 0.
+ * @row: Where to store row @i of the band, 2*@k + 1 cells.
+ *
+ * Computes row @i of the cost matrix inside the band, cell (i, j) going to
+ * position j - i + @k.  Costs above @k are capped at @k + 1.
+ **/
+static void
+band_row(size_t i, const lev_byte *string1,
+         size_t len2, const lev_byte *string2,
+         size_t k, const lev_cell *prev, lev_cell *row)
+{
+    const size_t w = 2*k + 1;
+    const lev_cell cap = (lev_cell)(k + 1);
+    const size_t jlo = i > k ? i - k : 0;
+    const size_t jhi = i + k < len2 - 1 ? i + k : len2 - 1;
+    size_t j, t;
+
+    for (t = 0; t < w; t++)
+        row[t] = cap;
+    for (j = jlo; j <= jhi; j++) {
+        size_t x, c3;
+        t = j + k - i;
+        if (!i)
+            x = j;
+        else if (!j)
+            x = i;
+        else {
+            x = prev[t] + (string1[i - 1] != string2[j - 1]);
+            if (t + 1 < w) {
+                c3 = prev[t + 1] + 1;
+                if (x > c3)
+                    x = c3;
+            }
+            if (t > 0) {
+                c3 = row[t - 1] + 1;
+                if (x > c3)
+                    x = c3;
+            }
+        }
+        row[t] = x > cap ? cap : (lev_cell)x;
+    }
+}
+
+/**
+ * band_distance:
+ * @len1: The number of matrix rows.
+ * @string1: The source string.
+ * @len2: The number of matrix columns.
+ * @string2: The destination string.
+ * @k: How far off the diagonal the band reaches, at least |@len1 - @len2|.
+ * @rows: Two rows of 2*@k + 1 cells to work in.
+ *
+ * Computes the edit distance inside the band, keeping only two rows.
+ *
+ * Returns: The distance when it is at most @k, otherwise @k + 1.
+ **/
+static size_t
+band_distance(size_t len1, const lev_byte *string1,
+              size_t len2, const lev_byte *string2,
+              size_t k, lev_cell *rows)
+{
+    const size_t w = 2*k + 1;
+    size_t i;
+
+    for (i = 0; i < len1; i++)
+        band_row(i, string1, len2, string2, k,
+                 rows + ((i + 1) & 1)*w, rows + (i & 1)*w);
+    return rows[((len1 - 1) & 1)*w + (len2 - 1) + k - (len1 - 1)];
+}
+
+/**
+ * editops_find_banded:
+ * @len1: The number of matrix rows (the length of @string1 plus one).
+ * @string1: The source string.
+ * @off1: The offset of @string1 in the original source string.
+ * @len2: The number of matrix columns (the length of @string2 plus one).
+ * @string2: The destination string.
+ * @off2: The offset of @string2 in the original destination string.
+ * @n: Where the number of edit operations should be stored.
+ * @scratch: Where to keep the band and the result, or NULL.
+ * @ops: Where the edit sequence should be stored.
+ *
+ * Finds the edit sequence of lev_editops_find_ex() for similar strings in
+ * O((len1 + len2)*distance) time.
+ *
+ * Only cells at most k off the diagonal can be on a path of cost k or
+ * less.  The distance is found first, in bands of doubling k of which
+ * only two rows are kept.  The band is never allowed more memory than the
+ * blocks of lev_editops_find_ex() would take (see block_layout()), so it
+ * costs little even when it gives up.  Then the band as wide as the
+ * distance is stored,
+ * with everything above it capped, and every cell the way back looks at
+ * is either exact or capped and too large to matter, so the result is
+ * the same as from the full matrix.
+ *
+ * Returns: Nonzero if the edit sequence was found (or memory ran out, in
+ *          which case *@n is (size_t)(-1)), zero if the full matrix should
+ *          be used instead.
+ **/
+static int
+editops_find_banded(size_t len1, const lev_byte *string1, size_t off1,
+                    size_t len2, const lev_byte *string2, size_t off2,
+                    size_t *n, LevScratch *scratch, LevEditOp **ops)
+{
+    size_t k, kmax, w, i, j, t, pos, rows, nblocks, cells;
+    lev_cell *band;
+    int dir = 0;
+
+    /* the widest band worth storing, in no more memory than the blocks */
+    cells = block_layout(len1, len2, &rows, &nblocks)/sizeof(lev_cell);
+    kmax = len2/LEV_BAND_MAX_FRACTION;
+    if (kmax > cells/len1)
+        kmax = cells/len1;
+    kmax = kmax ? (kmax - 1)/2 : 0;
+    if (kmax > 0xfffd)
+        kmax = 0xfffd;
+
+    k = len1 > len2 ? len1 - len2 : len2 - len1;
+    if (k < LEV_BAND_MIN)
+        k = LEV_BAND_MIN;
+    if (k > kmax)
+        return 0;
+
+    /* find the distance, or that it's more than kmax */
+    band = (lev_cell*)scratch_get(scratch, LEV_SCRATCH_WORK, 2*(2*kmax + 1)*sizeof(lev_cell));
+    if (!band) {
+        *n = (size_t)(-1);
+        *ops = NULL;
+        return 1;
+    }
+    for (;;) {
+        pos = band_distance(len1, string1, len2, string2, k, band);
+        if (pos <= k || k == kmax)
+            break;
+        k = 2*k < kmax ? 2*k : kmax;
+    }
+    scratch_put(scratch, band);
+    if (pos > k)
+        return 0;
+
+    *n = pos;
+    *ops = NULL;
+    if (!pos)
+        return 1;
+
+    /* the band the way back needs, the distance can't be below |len1 - len2| */
+    k = pos;
+    w = 2*k + 1;
+    band = (lev_cell*)scratch_get(scratch, LEV_SCRATCH_WORK, len1*w*sizeof(lev_cell));
+    if (!band) {
+        *n = (size_t)(-1);
+        return 1;
+    }
+    for (i = 0; i < len1; i++)
+        band_row(i, string1, len2, string2, k, i ? band + (i - 1)*w : NULL, band + i*w);
+
+    *ops = (LevEditOp*)scratch_get(scratch, LEV_SCRATCH_EDITOPS, pos*sizeof(LevEditOp));
+    if (!*ops)
+        *n = (size_t)(-1);
+    else {
+        i = len1 - 1;
+        j = len2 - 1;
+        t = j + k - i;
+        pos = editops_from_cost_block(string1, off1, string2, off2,
+                                      band + i*w + t, w - 1, 0,
+                                      &i, &j, &dir, pos, *ops);
+        assert(pos == 0 && i == 0 && j == 0);
+    }
+    scratch_put(scratch, band);
+    return 1;
 }
 
 
@@ -391,10 +770,43 @@ LevEditOp*
 lev_editops_find(size_t len1, const lev_byte *string1,
                  size_t len2, const lev_byte *string2,
                  size_t *n)
+{
+    return lev_editops_find_ex(len1, string1, len2, string2, n, NULL);
+}
+
+/**
+ * lev_editops_find_ex:
+ * @len1: The length of @string1.
+ * @string1: A string of length @len1, may contain NUL characters.
+ * @len2: The length of @string2.
+ * @string2: A string of length @len2, may contain NUL characters.
+ * @n: Where the number of edit operations should be stored.
+ * @scratch: Where to keep the cost matrix and the result, or NULL.
+ *
+ * lev_editops_find() with a reusable scratch context.
+ *
+ * The cost matrix is kept 16 bits per cell, and above a few million cells
+ * only a block of rows of it is kept at a time (plus the first row of every
+ * block), so memory grows with about len2*sqrt(len1) rather than len1*len2.
+ * Similar strings only compute a band around the diagonal, in time
+ * proportional to their distance.  The result is the same either way.
+ *
+ * Returns: The optimal edit sequence, stored in @scratch and valid until
+ *          it's used for edit operations again.  Without a context, the
+ *          array is newly allocated.
+ **/
+LevEditOp*
+lev_editops_find_ex(size_t len1, const lev_byte *string1,
+                    size_t len2, const lev_byte *string2,
+                    size_t *n, LevScratch *scratch)
 {
     size_t len1o, len2o;
-    size_t i;
-    size_t *matrix; /* cost matrix */
+    size_t i, j, b, pos;
+    size_t rows, nblocks; /* matrix rows per block, number of blocks */
+    size_t *work, *starts; /* work rows, first rows of blocks */
+    lev_cell *block; /* the stored block of the cost matrix */
+    LevEditOp *ops;
+    int dir = 0;
 
     /* strip common prefix */
     len1o = 0;
@@ -415,42 +827,61 @@ lev_editops_find(size_t len1, const lev_byte *string1,
     len1++;
     len2++;
 
-    /* initalize first row and column */
-    matrix = (size_t*)malloc(len1*len2*sizeof(size_t));
-    if (!matrix) {
+    /* similar strings only need a narrow band around the diagonal */
+    if (editops_find_banded(len1, string1, len1o, len2, string2, len2o,
+                            n, scratch, &ops))
+        return ops;
+
+    /* The matrix is stored in blocks of rows (see block_layout()).  The
+     * first row of every block is remembered in full on the way down, on
+     * the way back each block is recomputed from it.  Short inputs fit in
+     * a single block and are computed only once. */
+    work = (size_t*)scratch_get(scratch, LEV_SCRATCH_WORK,
+                                block_layout(len1, len2, &rows, &nblocks));
+    if (!work) {
         *n = (size_t)(-1);
         return NULL;
     }
+    starts = work + 2*len2;
+    block = (lev_cell*)(starts + nblocks*len2);
+
+    /* initalize first row, then find the first row of every block */
     for (i = 0; i < len2; i++)
-        matrix[i] = i;
-    for (i = 1; i < len1; i++)
-        matrix[len2*i] = i;
+        starts[i] = i;
+    for (b = 1; b < nblocks; b++) {
+        size_t *row = cost_rows((b - 1)*rows, b*rows, string1, len2, string2,
+                                starts + (b - 1)*len2, work, work + len2, NULL);
+        memcpy(starts + b*len2, row, len2*sizeof(size_t));
+    }
 
-    /* find the costs and fill the matrix */
-    for (i = 1; i < len1; i++) {
-        size_t *prev = matrix + (i - 1)*len2;
-        size_t *p = matrix + i*len2;
-        size_t *end = p + len2 - 1;
-        const lev_byte char1 = string1[i - 1];
-        const lev_byte *char2p = string2;
-        size_t x = i;
-        p++;
-        while (p <= end) {
-            size_t c3 = *(prev++) + (char1 != *(char2p++));
-            x++;
-            if (x > c3)
-                x = c3;
-            c3 = *prev + 1;
-            if (x > c3)
-                x = c3;
-            *(p++) = x;
+    /* find the way back, from the last block to the first */
+    ops = NULL;
+    pos = 0;
+    i = len1 - 1;
+    j = len2 - 1;
+    for (b = nblocks; b--; ) {
+        size_t lo = b*rows;
+        size_t hi = b + 1 == nblocks ? len1 - 1 : lo + rows;
+        size_t *row = cost_rows(lo, hi, string1, len2, string2,
+                                starts + b*len2, work, work + len2, block);
+        if (b + 1 == nblocks) {
+            pos = *n = row[len2 - 1];
+            if (!*n)
+                break;
+            ops = (LevEditOp*)scratch_get(scratch, LEV_SCRATCH_EDITOPS, (*n)*sizeof(LevEditOp));
+            if (!ops) {
+                *n = (size_t)(-1);
+                break;
+            }
         }
+        pos = editops_from_cost_block(string1, len1o, string2, len2o,
+                                      block + (i - lo)*len2 + j, len2, lo,
+                                      &i, &j, &dir, pos, ops);
     }
+    assert(!ops || (pos == 0 && i == 0 && j == 0));
+    scratch_put(scratch, work);
 
-    /* find the way back */
-    return editops_from_cost_matrix(len1, string1, len1o,
-                                    len2, string2, len2o,
-                                    matrix, n);
+    return ops;
 }
 
 /**
@@ -632,6 +1063,29 @@ lev_u_edit_distance(size_t len1, const lev_wchar *string1,
 LevOpCode*
 lev_editops_to_opcodes(size_t n, const LevEditOp *ops, size_t *nb,
                        size_t len1, size_t len2)
+{
+    return lev_editops_to_opcodes_ex(n, ops, nb, len1, len2, NULL);
+}
+
+/**
+ * lev_editops_to_opcodes_ex:
+ * @n: The size of @ops.
+ * @ops: An array of elementary edit operations.
+ * @nb: Where the number of difflib block operation codes should be stored.
+ * @len1: The length of the source string.
+ * @len2: The length of the destination string.
+ * @scratch: Where to store the result, or NULL.
+ *
+ * lev_editops_to_opcodes() with a reusable scratch context.  @ops may be
+ * the result of lev_editops_find_ex() in the same context.
+ *
+ * Returns: The converted block operation codes, stored in @scratch and
+ *          valid until it's used for opcodes again.  Without a context,
+ *          the array is newly allocated.
+ **/
+LevOpCode*
+lev_editops_to_opcodes_ex(size_t n, const LevEditOp *ops, size_t *nb,
+                          size_t len1, size_t len2, LevScratch *scratch)
 {
     size_t nbl, i, spos, dpos;
     const LevEditOp *o;
@@ -690,7 +1144,7 @@ lev_editops_to_opcodes(size_t n, const LevEditOp *ops, size_t *nb,
         nbl++;
 
     /* convert */
-    b = bops = (LevOpCode*)malloc(nbl*sizeof(LevOpCode));
+    b = bops = (LevOpCode*)scratch_get(scratch, LEV_SCRATCH_OPCODES, nbl*sizeof(LevOpCode));
     if (!bops) {
         *nb = (size_t)(-1);
         return NULL;
@@ -779,10 +1233,37 @@ lev_editops_to_opcodes(size_t n, const LevEditOp *ops, size_t *nb,
  **/
 LevMatchingBlock*
 lev_opcodes_matching_blocks(size_t len1,
-                            __attribute__((unused)) size_t len2,
+                            size_t len2,
                             size_t nb,
                             const LevOpCode *bops,
                             size_t *nmblocks)
+{
+    return lev_opcodes_matching_blocks_ex(len1, len2, nb, bops, nmblocks, NULL);
+}
+
+/**
+ * lev_opcodes_matching_blocks_ex:
+ * @len1: The length of the source string.
+ * @len2: The length of the destination string.
+ * @nb: The size of @bops.
+ * @bops: An array of difflib block edit operation codes.
+ * @nmblocks: Where the number of matching block should be stored.
+ * @scratch: Where to store the result, or NULL.
+ *
+ * lev_opcodes_matching_blocks() with a reusable scratch context.  @bops
+ * may be the result of lev_editops_to_opcodes_ex() in the same context.
+ *
+ * Returns: The matching blocks, stored in @scratch and valid until it's
+ *          used for matching blocks again.  Without a context, the array
+ *          is newly allocated.
+ **/
+LevMatchingBlock*
+lev_opcodes_matching_blocks_ex(size_t len1,
+                               __attribute__((unused)) size_t len2,
+                               size_t nb,
+                               const LevOpCode *bops,
+                               size_t *nmblocks,
+                               LevScratch *scratch)
 {
     size_t nmb, i;
     const LevOpCode *b;
@@ -805,7 +1286,7 @@ lev_opcodes_matching_blocks(size_t len1,
     }
 
     /* convert */
-    mb = mblocks = (LevMatchingBlock*)malloc(nmb*sizeof(LevOpCode));
+    mb = mblocks = (LevMatchingBlock*)scratch_get(scratch, LEV_SCRATCH_BLOCKS, nmb*sizeof(LevOpCode));
     if (!mblocks) {
         *nmblocks = (size_t)(-1);
         return NULL;
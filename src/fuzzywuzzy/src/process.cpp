@@ -1,6 +1,7 @@
 #include "process.hpp"
 
 #include <set>
+#include <unordered_map>
 
 namespace fuzz
 {
@@ -8,14 +9,18 @@ namespace fuzz
 using std::set;
 
 vector<pair<string, int>> extractWithoutOrder(const string& query, const vector<string>& choices
-    , function<string(string)> processor, function<int(string, string, const bool)> scorer
+    , function<string(string)> processor, function<int(string, string, const bool, const unsigned int)> scorer
     , int score_cutoff)
 {
     string processed_query = processor(query);
 
-    /* TODO: Avoid running full_process twice. */
-    
-    auto score_func = [&scorer] (const string& s1, const string& s2) { return scorer(s1, s2, false); };
+    /* full_process is idempotent, so don't run it twice when it is also the processor. */
+    auto target = processor.target<string (*)(string)>();
+    const bool skip_pre_processor = target && *target == utils::full_process;
+
+    /* Scores below the cutoff are dropped anyway, so let the scorer give up on them early. */
+    const unsigned int cutoff = static_cast<unsigned int>(std::max(0, score_cutoff));
+    auto score_func = [&scorer, cutoff] (const string& s1, const string& s2) { return scorer(s1, s2, false, cutoff); };
     auto pre_processor = utils::full_process;
 
     /* NOTE: Why? But the Python version does the following. */
@@ -23,7 +28,7 @@ vector<pair<string, int>> extractWithoutOrder(const string& query, const vector<
 
     vector<pair<string, int>> results;
     for(const auto& choice : choices) {
-        string processed = pre_processor(processor(choice));
+        string processed = skip_pre_processor ? processor(choice) : pre_processor(processor(choice));
         int score = score_func(processed_query, processed);
         if(score >= score_cutoff)
             results.emplace_back(choice, score);
@@ -33,14 +38,15 @@ vector<pair<string, int>> extractWithoutOrder(const string& query, const vector<
 }
 
 vector<pair<string, int>> extractBests(const string& query, const vector<string>& choices
-    , function<string(string)> processor, function<int(string, string, const bool)> scorer
+    , function<string(string)> processor, function<int(string, string, const bool, const unsigned int)> scorer
     , int score_cutoff, intmax_t limit)
 {
     auto sl = extractWithoutOrder(query, choices, processor, scorer, score_cutoff);
     if(limit == -1)
         return sl;
 
-    std::partial_sort(sl.begin(), sl.begin()+limit, sl.end(), [](const auto& a, const auto& b){ return a.second > b.second; });
+    auto middle = sl.begin() + std::min(sl.size(), (size_t)limit);
+    std::partial_sort(sl.begin(), middle, sl.end(), [](const auto& a, const auto& b){ return a.second > b.second; });
 
     /* If limit < 0, it means to return everything. Since vector::size() is always */
     /* larger than -1, we can combine the check. */
@@ -52,62 +58,95 @@ vector<pair<string, int>> extractBests(const string& query, const vector<string>
 }
 
 vector<pair<string, int>> extract(const string& query, const vector<string>& choices
-    , function<string(string)> processor, function<int(string, string, const bool)> scorer
+    , function<string(string)> processor, function<int(string, string, const bool, const unsigned int)> scorer
     , intmax_t limit)
 {
     return extractBests(query, choices, processor, scorer, 0, limit);
 }
 
 vector<pair<string, int>> extractOne(const string& query, const vector<string>& choices
-    , function<string(string)> processor, function<int(string, string, const bool)> scorer
+    , function<string(string)> processor, function<int(string, string, const bool, const unsigned int)> scorer
     , int score_cutoff)
 {
     return extractBests(query, choices, processor, scorer, score_cutoff, 1);
 }
 
-vector<string> dedupe(const vector<string>& contains_dupes, int threshold, function<int(string, string, const bool)> scorer)
+/*
+ * dedupe() sorts the strings scoring above the threshold by length, then by their first character
+ * (both descending, stable), and keeps the first. This is "a comes before b" in that order.
+ */
+static bool canonical_before(const string& a, size_t a_index, const string& b, size_t b_index)
 {
-    /* NOTE: This function is a translation of the python and it can be optimized a lot. The original algorithm is */
-    /* far from ideal. */
-    vector<string> extractor;
-
-    for(const auto& str : contains_dupes) {
-        auto matches = extract(str, contains_dupes, utils::full_process, scorer, -1);
-
-        vector<string> filtered;
-        for(size_t i=0;i<matches.size();i++) {
-            int score = matches[i].second;
-            string value = matches[i].first;
-            if(score > threshold)
-                filtered.push_back(value);
+    if(a.size() != b.size())
+        return a.size() > b.size();
+    if(a[0] != b[0])
+        return a[0] > b[0];
+    return a_index < b_index;
+}
+
+vector<string> dedupe(const vector<string>& contains_dupes, int threshold
+    , function<int(string, string, const bool, const unsigned int)> scorer, unsigned int workers)
+{
+    const size_t npos = static_cast<size_t>(-1);
+
+    /*
+     * Scores only depend on the processed strings, so every string is processed once and the
+     * strings are indexed by their processed form. Each distinct form is then scored against
+     * every other one a single time, instead of every string against every string.
+     *
+     * NOTE: "scores above the threshold" is not transitive, so each form keeps its own set of
+     * neighbours rather than being merged into clusters.
+     */
+    std::unordered_map<string, size_t> form_index;
+    vector<string> forms;
+    vector<size_t> form_of(contains_dupes.size());
+    /* For each form, the string that comes first in canonical order among those with this form. */
+    vector<size_t> best_of_form;
+
+    for(size_t i = 0; i < contains_dupes.size(); i++) {
+        auto inserted = form_index.emplace(utils::full_process(contains_dupes[i]), forms.size());
+        if(inserted.second) {
+            forms.push_back(inserted.first->first);
+            best_of_form.push_back(i);
         }
 
-        /* if there is only 1 item in *filtered*, no duplicates were found so append to *extracted* */
-        if(filtered.size() == 1)
-            extractor.push_back(*filtered.begin());
-        else {
-            /* alpha sort */
-            std::stable_sort(filtered.begin(), filtered.end(), [](const auto& a, const auto& b){ return a[0] > b[0]; });
+        const size_t form = inserted.first->second;
+        form_of[i] = form;
+        if(canonical_before(contains_dupes[i], i, contains_dupes[best_of_form[form]], best_of_form[form]))
+            best_of_form[form] = i;
+    }
 
-            /* length sort */
-            std::stable_sort(filtered.begin(), filtered.end(), [](const auto& a, const auto& b){ return a.size() > b.size(); });
+    /* A score has to be above the threshold to count, let the scorer give up below that. */
+    const unsigned int cutoff = static_cast<unsigned int>(std::max(0, threshold + 1));
 
-            /* take first item as our 'canonical example' */
-            extractor.push_back(*filtered.begin());
+    /* The canonical string for each form, or npos if nothing (not even the form itself) scored high enough. */
+    vector<size_t> canonical(forms.size(), npos);
+    detail::parallel_for(forms.size(), workers, [&](size_t query, unsigned int) {
+        size_t best = npos;
+        for(size_t choice = 0; choice < forms.size(); choice++) {
+            if(scorer(forms[query], forms[choice], false, cutoff) <= threshold)
+                continue;
+
+            const size_t candidate = best_of_form[choice];
+            if(best == npos || canonical_before(contains_dupes[candidate], candidate, contains_dupes[best], best))
+                best = candidate;
         }
-    }
+        canonical[query] = best;
+    });
 
-    // uniquify *extractor* list
+    // uniquify the canonical strings
     set<string> keys;
-    for(auto str : extractor)
-        keys.insert(str);
-        
+    for(size_t i = 0; i < contains_dupes.size(); i++) {
+        const size_t best = canonical[form_of[i]];
+        keys.insert(best == npos ? contains_dupes[i] : contains_dupes[best]);
+    }
+
     /* check that extractor differs from contain_dupes (e.g. duplicates were found) */
     /* if not, then return the original list */
     if(keys.size() == contains_dupes.size())
         return contains_dupes;
     else
-        return vector<string>(keys.begin(), keys.end());  
+        return vector<string>(keys.begin(), keys.end());
 }
 
 }  // ns fuzz
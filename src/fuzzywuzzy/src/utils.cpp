@@ -1,5 +1,6 @@
 #include "utils.hpp"
 
+#include <array>
 #include <cmath>
 
 namespace fuzz {
@@ -75,32 +76,74 @@ string& trim(string &str)
 string join(const vector<string> &v, const string &sep)
 {
     string retstr = "";
-    for (const auto &str : v)
-        retstr += str + (str == v.back() ? "" : sep);
+    for (size_t i = 0; i < v.size(); i++) {
+        if (i > 0)
+            retstr += sep;
+        retstr += v[i];
+    }
 
     return retstr;
 }
 
+/*
+ * What full_process() turns every byte into: ASCII letters and digits in
+ * lower case, everything else a space. This is what isalnum() and
+ * tolower() do in the "C" locale, which the library never changes.
+ */
+static constexpr std::array<char, 256> make_process_table()
+{
+    std::array<char, 256> table{};
+    for (int c = 0; c < 256; c++) {
+        if (c >= 'A' && c <= 'Z')
+            table[c] = static_cast<char>(c - 'A' + 'a');
+        else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+            table[c] = static_cast<char>(c);
+        else
+            table[c] = ' ';
+    }
+    return table;
+}
+
+static constexpr std::array<char, 256> process_table = make_process_table();
+
+static inline char process_char(char c)
+{
+    return process_table[static_cast<unsigned char>(c)];
+}
+
+size_t full_process_into(const char *str, size_t len, char *out)
+{
+    /* Whatever maps to a space at either end gets trimmed. */
+    size_t start = 0, end = len;
+    while (start < end && process_char(str[start]) == ' ')
+        start++;
+    while (end > start && process_char(str[end - 1]) == ' ')
+        end--;
+
+    for (size_t i = start; i < end; i++)
+        out[i - start] = process_char(str[i]);
+
+    return end - start;
+}
+
+string_view full_process_into(string_view str, string &buf)
+{
+    buf.resize(str.size());
+    buf.resize(full_process_into(str.data(), str.size(), &buf[0]));
+    return buf;
+}
+
 /*
  * Process the string by
  *  - replace non-alphanumeric characters with whitespace,
  *  - trim whitespace, and
  *  - forcing to lower case.
+ *
+ * All three happen in one pass over a lookup table, in place.
  */
 string full_process(string str)
 {
-    /* Replace non-alphanumeric characters with whitespace, */
-    std::replace_if(str.begin(), str.end(), [](char ch) {
-        /* NOTE: same thing here: specify locale? */
-        return !std::isalnum(ch);
-    }, ' ');
-
-    /* trim whitespace, and */
-    str = utils::trim(str);
-
-    /* force to lower case. */
-    std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-
+    str.resize(full_process_into(str.data(), str.size(), &str[0]));
     return str;
 }
 
@@ -4,21 +4,36 @@
 
 namespace wrapper {
 
-double ratio(const string &str1, const string &str2)
+/*
+ * The levenshtein.c scratch context of this thread, so the C functions
+ * reuse their buffers instead of going through malloc() on every call.
+ */
+static LevScratch *scratch()
+{
+    struct holder {
+        LevScratch s;
+        holder() { lev_scratch_init(&s); }
+        ~holder() { lev_scratch_free(&s); }
+    };
+    static thread_local holder h;
+    return &h.s;
+}
+
+double ratio(string_view str1, string_view str2)
 {
     size_t len1 = str1.length(),
            len2 = str2.length();
 
-    const lev_byte *lb1 = reinterpret_cast<const lev_byte *>(str1.c_str()),
-                   *lb2 = reinterpret_cast<const lev_byte *>(str2.c_str());
+    const lev_byte *lb1 = reinterpret_cast<const lev_byte *>(str1.data()),
+                   *lb2 = reinterpret_cast<const lev_byte *>(str2.data());
 
     size_t lensum = len1 + len2;
-    size_t edit_dist = lev_edit_distance(len1, lb1, len2, lb2, 1);
+    size_t edit_dist = lev_edit_distance_ex(len1, lb1, len2, lb2, 1, scratch());
 
     return static_cast<double>(lensum - edit_dist) / static_cast<double>(lensum);
 }
 
-vector<LevOpCode> get_opcodes(string &s1, string &s2)
+vector<LevOpCode> get_opcodes(string_view s1, string_view s2)
 {
     vector<LevOpCode> opcodes;
     size_t len1, len2, nb, n;
@@ -29,23 +44,21 @@ vector<LevOpCode> get_opcodes(string &s1, string &s2)
     len1 = s1.length();
     len2 = s2.length();
 
-    lb1 = reinterpret_cast<const lev_byte *>(s1.c_str());
-    lb2 = reinterpret_cast<const lev_byte *>(s2.c_str());
+    lb1 = reinterpret_cast<const lev_byte *>(s1.data());
+    lb2 = reinterpret_cast<const lev_byte *>(s2.data());
 
-    ops = lev_editops_find(len1, lb1, len2, lb2, &n);
+    /* Both arrays live in the scratch context, only the result is copied. */
+    ops = lev_editops_find_ex(len1, lb1, len2, lb2, &n, scratch());
     if (ops != nullptr) {
-        bops = lev_editops_to_opcodes(n, ops, &nb, len1, len2);
-        if (bops != nullptr) {
+        bops = lev_editops_to_opcodes_ex(n, ops, &nb, len1, len2, scratch());
+        if (bops != nullptr)
             opcodes.assign(bops, bops + nb);
-            free(bops);
-        }
-        free(ops);
     }
 
     return opcodes;
 }
 
-vector<LevEditOp> get_editops(string &s1, string &s2)
+vector<LevEditOp> get_editops(string_view s1, string_view s2)
 {
     vector<LevEditOp> editops;
     size_t len1, len2, n;
@@ -55,23 +68,21 @@ vector<LevEditOp> get_editops(string &s1, string &s2)
     len1 = s1.length();
     len2 = s2.length();
 
-    lb1 = reinterpret_cast<const lev_byte *>(s1.c_str());
-    lb2 = reinterpret_cast<const lev_byte *>(s2.c_str());
+    lb1 = reinterpret_cast<const lev_byte *>(s1.data());
+    lb2 = reinterpret_cast<const lev_byte *>(s2.data());
 
-    ops = lev_editops_find(len1, lb1, len2, lb2, &n);
-    if (ops != nullptr) {
+    ops = lev_editops_find_ex(len1, lb1, len2, lb2, &n, scratch());
+    if (ops != nullptr)
         editops.assign(ops, ops + n);
-        free(ops);
-    }
 
     return editops;
 }
 
-vector<LevOpCode> get_opcodes(vector<LevEditOp> &v, string &s1, string &s2)
+vector<LevOpCode> get_opcodes(const vector<LevEditOp> &v, string_view s1, string_view s2)
 {
     vector<LevOpCode> opcodes;
     size_t len1, len2, n;
-    LevEditOp *ops;
+    const LevEditOp *ops;
     LevOpCode *bops;
 
     n = v.size();
@@ -79,16 +90,14 @@ vector<LevOpCode> get_opcodes(vector<LevEditOp> &v, string &s1, string &s2)
     len2 = s2.length();
 
     ops = v.data();
-    bops = lev_editops_to_opcodes(n, ops, &n, len1, len2);
-    if (bops != nullptr) {
+    bops = lev_editops_to_opcodes_ex(n, ops, &n, len1, len2, scratch());
+    if (bops != nullptr)
         opcodes.assign(bops, bops + n);
-        free(bops);
-    }
 
     return opcodes;
 }
 
-vector<LevMatchingBlock> get_matching_blocks(vector<LevOpCode> &v, string &s1, string &s2)
+vector<LevMatchingBlock> get_matching_blocks(const vector<LevOpCode> &v, string_view s1, string_view s2)
 {
     vector<LevMatchingBlock> blocks;
     size_t n, nmb, len1, len2;
@@ -98,11 +107,9 @@ vector<LevMatchingBlock> get_matching_blocks(vector<LevOpCode> &v, string &s1, s
     len1 = s1.length();
     len2 = s2.length();
 
-    mblocks = lev_opcodes_matching_blocks(len1, len2, n, v.data(), &nmb);
-    if (mblocks != nullptr) {
+    mblocks = lev_opcodes_matching_blocks_ex(len1, len2, n, v.data(), &nmb, scratch());
+    if (mblocks != nullptr)
         blocks.assign(mblocks, mblocks + nmb);
-        free(mblocks);
-    }
 
     return blocks;
 }
@@ -1,6 +1,12 @@
 #include "lexer.h"
+#include "lexerprofiles.h"
+#include "lexerscan.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <cstdarg>
 #include <strings.h>
+#include <thread>
 
 #include "debug.h"
 #include "charbuffer.h"
@@ -11,31 +17,53 @@ char const * tokenTypeNames[cToken::MAX_TOKEN_TYPE] = {
 	"none", "punctuation", "name", "string", "number"
 };
 
-static const char * punctuationNames = "!~.,=?<>:;()[]{}|/\\+-*&^%$#@\"\'";
+// cLexer's comment functions can start a comment on any character, so every one is a candidate
+static constexpr sLexerCharTable MakeRuntimeCharTable( char const * punctuation ) {
+	sLexerCharTable table = MakeLexerCharTable( punctuation, "" );
+	for ( int i = 0; i < 256; ++i ) {
+		table.mClass[i] |= sLexerCharTable::CHAR_COMMENT;
+	}
+	return table;
+}
+
+static constexpr sLexerCharTable defaultCharTable = MakeRuntimeCharTable( cLexerBase::DEFAULT_PUNCTUATION );
 
 char const * cToken::GetTokenTypeName( eTokenType const tokenType ) {
 	return tokenTypeNames[tokenType];
 }
 
-static cLexer::ePunctuation FindPunctuationType( const char * punctuationNames, char const ch ) {
-	for ( int i = 0; punctuationNames[i] != '\0'; i++ ) {
-		if ( ch == punctuationNames[ i ] ) {
-			return static_cast< cLexer::ePunctuation >( i );
-		}
-	}
-	return cLexer::PUNC_NONE;
+void cLineIndex::Build( char const * text, size_t const len ) {
+	mNewlines.clear();
+	FindNewlines( text, text + len, mNewlines );
+}
+
+int32_t cLineIndex::GetLine( size_t const offset ) const {
+	// the number of newlines before the offset
+	return static_cast< int32_t >( std::lower_bound( mNewlines.begin(), mNewlines.end(), offset ) - mNewlines.begin() );
+}
+
+int32_t cLineIndex::GetLineOffset( size_t const offset ) const {
+	int32_t const line = GetLine( offset );
+	return static_cast< int32_t >( line == 0 ? offset : offset - mNewlines[line - 1] - 1 );
 }
 
-char cLexer::GetPunctuationName( ePunctuation const punc ) {
+template< typename tProfile >
+char cLexerT< tProfile >::GetPunctuationName( ePunctuation const punc ) const {
 	if ( punc <= PUNC_NONE || punc >= PUNC_MAX ) {
 		return 0;
 	}
 
-	OTTER_ASSERT( punc < static_cast< int32_t >( mNumPunctuation ) );
-	return mPunctuationNames[punc];
+	// the table maps characters to punctuation, so look for the character that maps back
+	sLexerCharTable const & table = mProfile.GetCharTable();
+	for ( int ch = 0; ch < 256; ++ch ) {
+		if ( table.mPunctuation[ch] == punc ) {
+			return static_cast< char >( ch );
+		}
+	}
+	return 0;
 }
 
-bool cLexer::cErrorHandler::Error( char const * fmt, ... ) {
+bool cLexerBase::cErrorHandler::Error( char const * fmt, ... ) {
 	char errorMsg[512];
 
 	va_list args;
@@ -48,25 +76,7 @@ bool cLexer::cErrorHandler::Error( char const * fmt, ... ) {
 	return false;
 }
 
-void cLexer::BuildPunctuationTable( const char * punctuation ) {
-	const size_t len = strlen( punctuation );
-	mPunctuationNames = new char[len + 1];
-	OT_STRCPY( const_cast< char * >( mPunctuationNames ), len + 1, punctuation );
-
-	for ( int i = 0; i < PUNC_TABLE_SIZE; ++i ) {
-		mPunctuationTable[i] = cLexer::PUNC_NONE;
-	}
-	for ( int i = 0; punctuation[i] != '\0'; ++i ) {
-		const uint8_t ch = static_cast< uint8_t >( punctuation[i] );
-		mPunctuationTable[ch] = FindPunctuationType( punctuation, ch );
-	}
-}
-
-cLexer::ePunctuation cLexer::GetPunctuationType( const char ch ) const {
-	return mPunctuationTable[static_cast< uint8_t >( ch )];
-}
-
-static cLexer::eCommentType GetCommentType( uint32_t const flags, char const curChar, char const nextChar ) {
+static cLexerBase::eCommentType GetDefaultCommentType( uint32_t const flags, char const curChar, char const nextChar ) {
 	constexpr bool allowSingleLineComments = true;
 	constexpr bool allowHashComments = true;
 
@@ -85,7 +95,7 @@ static cLexer::eCommentType GetCommentType( uint32_t const flags, char const cur
 	return cLexer::COMMENT_NONE;
 }
 
-static bool IsCommentEnd( uint32_t const flags, cLexer::eCommentType const commentType, char const curChar, char const nextChar ) {
+static bool IsDefaultCommentEnd( uint32_t const flags, cLexerBase::eCommentType const commentType, char const curChar, char const nextChar ) {
 	constexpr bool allowSingleLineComments = true;
 
 	OTTER_ASSERT( commentType != cLexer::COMMENT_NONE );
@@ -138,7 +148,28 @@ static bool IsCommentEnd( uint32_t const flags, eCommentType const commentType,
 }
 */
 
-cLexer::cLexer( char const * name, char const * text, size_t const len, const uint32_t flags ) 
+cRuntimeLexerProfile::cRuntimeLexerProfile()
+	: mCommentTypeFn( GetDefaultCommentType )
+	, mCommentEndFn( IsDefaultCommentEnd )
+	, mCharTable( &defaultCharTable ) {
+}
+
+void cRuntimeLexerProfile::Init( cLexerBase::sInitParms const & initParms ) {
+	if ( initParms.mCommentTypeFn != nullptr ) {
+		mCommentTypeFn = initParms.mCommentTypeFn;
+	}
+	if ( initParms.mCommentEndFn != nullptr ) {
+		mCommentEndFn = initParms.mCommentEndFn;
+	}
+	// the default punctuation keeps the shared table, only other punctuation gets a table of its own
+	if ( initParms.mPunctuation != nullptr && strcmp( initParms.mPunctuation, cLexerBase::DEFAULT_PUNCTUATION ) != 0 ) {
+		mOwnCharTable.reset( new sLexerCharTable( MakeRuntimeCharTable( initParms.mPunctuation ) ) );
+		mCharTable = mOwnCharTable.get();
+	}
+}
+
+template< typename tProfile >
+cLexerT< tProfile >::cLexerT( char const * name, char const * text, size_t const len, const uint32_t flags ) 
 	: mName( name )
 	, mText( text )
 	, mLen( len )
@@ -146,13 +177,11 @@ cLexer::cLexer( char const * name, char const * text, size_t const len, const ui
 	, mCur( text )
 	, mEnd( text + len )
 	, mLineStart( text )
-	, mLine( 0 )
-	, mCommentTypeFn( GetCommentType )
-	, mCommentEndFn( IsCommentEnd ) {
-	BuildPunctuationTable( punctuationNames );
+	, mLine( 0 ) {
 }
 
-cLexer::cLexer( char const * name, char const * text, size_t const len, const sInitParms & initParms ) 
+template< typename tProfile >
+cLexerT< tProfile >::cLexerT( char const * name, char const * text, size_t const len, const sInitParms & initParms ) 
 	: mName( name )
 	, mText( text )
 	, mLen( len )
@@ -161,55 +190,180 @@ cLexer::cLexer( char const * name, char const * text, size_t const len, const sI
 	, mEnd( text + len )
 	, mLineStart( text )
 	, mLine( 0 )
-	, mFileIndex( initParms.mFileIndex )
-	, mCommentTypeFn( initParms.mCommentTypeFn )
-	, mCommentEndFn( initParms.mCommentEndFn ) {
-	BuildPunctuationTable( initParms.mPunctuation == nullptr ? punctuationNames : initParms.mPunctuation );
+	, mFileIndex( initParms.mFileIndex ) {
 }
 
-cLexer::~cLexer() {
-	delete [] mPunctuationNames;
-	mPunctuationNames = nullptr;
+template< typename tProfile >
+cLexerT< tProfile >::cLexerT( cLexerT const & other, char const * cur, int32_t const line ) 
+	: mProfile( other.mProfile )
+	, mName( other.mName )
+	, mText( other.mText )
+	, mLen( other.mLen )
+	, mFlags( other.mFlags )
+	, mCur( cur )
+	, mEnd( other.mEnd )
+	, mLineStart( ( other.mFlags & FLAG_NO_LINES ) != 0 ? other.mLineStart : cur )
+	, mLine( line )
+	, mFileIndex( other.mFileIndex ) {
 }
 
-static bool IsWhitespace( char const ch ) {
-	return ( ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' );
+cLexer::cLexer( char const * name, char const * text, size_t const len, const uint32_t flags ) 
+	: cLexerT( name, text, len, flags ) {
+}
+
+cLexer::cLexer( char const * name, char const * text, size_t const len, const sInitParms & initParms ) 
+	: cLexerT( name, text, len, initParms ) {
+	mProfile.Init( initParms );
 }
 
 static bool IsEndOfLine( char const ch ) {
 	return ch == '\n';
 }
 
-bool cLexer::SkipWhitespace() {
-	if ( !IsWhitespace( *mCur ) ) {
+static bool IsHexDigit( char const ch ) {
+	return ( ch >= '0' && ch <= '9' ) || ( ch >= 'a' && ch <= 'f' ) || ( ch >= 'A' && ch <= 'F' );
+}
+
+// true if p starts 0x or 0X and a hex digit
+static bool IsHexStart( char const * p, char const * end ) {
+	return end - p > 2 && p[0] == '0' && ( p[1] == 'x' || p[1] == 'X' ) && IsHexDigit( p[2] );
+}
+
+// sets the value of a number token from its text. As with strtod and strtol, anything after the number,
+// such as a trailing 'f' or 'L', is ignored. Nothing depends on the locale.
+static void ParseNumber( char const * start, char const * end, int32_t const subType, cToken & token ) {
+	if ( subType == cToken::INTEGER ) {
+		// integers too big for int64_t saturate, as strtol does, but the double keeps their real value
+		int64_t integer = 0;
+		double number = 0.0;
+		bool const negative = *start == '-';
+		char const * digits = negative ? start + 1 : start;
+		if ( IsHexStart( digits, end ) ) {
+			uint64_t magnitude = 0;
+			std::from_chars_result const r = std::from_chars( digits + 2, end, magnitude, 16 );
+			uint64_t const limit = negative ? static_cast< uint64_t >( INT64_MAX ) + 1 : INT64_MAX;
+			if ( r.ec == std::errc::result_out_of_range || magnitude > limit ) {
+				integer = negative ? INT64_MIN : INT64_MAX;
+			} else {
+				integer = static_cast< int64_t >( negative ? 0 - magnitude : magnitude );
+			}
+			if ( std::from_chars( digits + 2, end, number, std::chars_format::hex ).ec == std::errc::result_out_of_range ) {
+				number = HUGE_VAL;
+			}
+			token.SetNumber( negative ? -number : number, integer );
+			return;
+		}
+		if ( std::from_chars( start, end, integer ).ec != std::errc::result_out_of_range ) {
+			token.SetNumber( static_cast< double >( integer ), integer );
+			return;
+		}
+		integer = negative ? INT64_MIN : INT64_MAX;
+		std::from_chars( start, end, number );
+		token.SetNumber( number, integer );
+		return;
+	}
+	double number = 0.0;
+	if ( std::from_chars( start, end, number ).ec == std::errc::result_out_of_range ) {
+		// from_chars leaves the value alone when it overflows or underflows, strtod gives what they should
+		number = strtod( token.GetText(), nullptr );
+	}
+	bool const fitsInteger = std::fabs( number ) < 9.2e18;
+	token.SetNumber( number, fitsInteger ? static_cast< int64_t >( number ) : 0 );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::SkipWhitespace() {
+	if ( AtEnd() || !IsWhitespace( *mCur ) ) {
 		return false;
 	}
-	while( !AtEnd() && IsWhitespace( *mCur ) ) {
-		if ( IsEndOfLine( *mCur ) ) {
-			mLine++;
-			mLineStart = mCur + 1;
-		}
-		mCur++;
+	if ( TrackLines() ) {
+		mCur = ScanWhitespace( mCur, mEnd, mLine, mLineStart );
+	} else {
+		mCur = SkipWhitespaceChars( mCur, mEnd );
 	}
 	return true;
 }
 
-bool cLexer::SkipComments() {
-	eCommentType ct = mCommentTypeFn( mFlags, *mCur, *( mCur + 1 ) );
+template< typename tProfile >
+bool cLexerT< tProfile >::SkipComments() {
+	// carry on with a comment the last window ended in
+	eCommentType ct = mOpenComment;
+	mOpenComment = COMMENT_NONE;
 	if ( ct == COMMENT_NONE ) {
-		return false;
+		if ( AtEnd() || ( GetCharClass( *mCur ) & sLexerCharTable::CHAR_COMMENT ) == 0 ) {
+			return false;
+		}
+		ct = mProfile.GetCommentType( mFlags, *mCur, PeekChar() );
+		if ( ct == COMMENT_NONE ) {
+			return false;
+		}
 	}
-	while ( !AtEnd() && !mCommentEndFn( mFlags, ct, *mCur, * (mCur + 1 ) ) ) {
-		if ( IsEndOfLine( *mCur ) ) {
+	SkipCommentBody( ct );
+	if ( !mFinal && mCur >= mEnd ) {
+		// the comment goes on into the next window. Its last character stays to be looked at again, in
+		// case it begins the end of the comment, unless it is a newline that has already been counted.
+		mOpenComment = ct;
+		if ( *( mEnd - 1 ) != '\n' ) {
+			mCur = mEnd - 1;
+		}
+	}
+	return true;
+}
+
+template< typename tProfile >
+void cLexerT< tProfile >::SkipCommentBody( eCommentType const ct ) {
+	if constexpr ( tProfile::SCAN_AHEAD ) {
+		if ( ct == COMMENT_BLOCK ) {
+			for ( ; ; ) {
+				char const * p = FindEither( mCur, mEnd, tProfile::BLOCK_COMMENT_END[0], '\0' );
+				if ( TrackLines() ) {
+					mLine += CountNewlines( mCur, p, mLineStart );
+				}
+				mCur = p;
+				if ( AtEnd() || PeekChar() == tProfile::BLOCK_COMMENT_END[1] ) {
+					break;
+				}
+				mCur++;
+			}
+		} else {
+			// the '\n' ending a line comment is left for SkipWhitespace
+			mCur = FindEither( mCur, mEnd, '\n', '\0' );
+		}
+		return;
+	}
+	while ( !AtEnd() && !mProfile.IsCommentEnd( mFlags, ct, *mCur, PeekChar() ) ) {
+		if ( IsEndOfLine( *mCur ) && TrackLines() ) {
 			mLine++;
 			mLineStart = mCur + 1;
 		}
 		mCur++;
 	}
-	return true;
 }
 
-bool cLexer::Error( char const * fmt, ... ) const {
+template< typename tProfile >
+int32_t cLexerT< tProfile >::GetLine() const {
+	if ( mLookaheadCount == 0 ) {
+		return GetLexLine();
+	}
+	sLookahead const & next = mLookahead[mLookaheadFirst];
+	if ( TrackLines() ) {
+		return next.mLine;
+	}
+	char const * lineStart = mText;
+	return CountNewlines( mText, next.mCur, lineStart );
+}
+
+template< typename tProfile >
+int32_t cLexerT< tProfile >::GetLexLine() const {
+	if ( TrackLines() ) {
+		return mLine;
+	}
+	char const * lineStart = mText;
+	return CountNewlines( mText, mCur, lineStart );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::Error( char const * fmt, ... ) const {
 	char temp[ 512 ];
 
 	va_list	argPtr;
@@ -217,22 +371,21 @@ bool cLexer::Error( char const * fmt, ... ) const {
 	OT_VSNPRINTF( temp, sizeof( temp ), fmt, argPtr );
 	va_end( argPtr );
 
-	debugout( "%s(%d) : %s\n", mName.c_str(), mLine, temp );
+	int32_t const line = GetLexLine();
+	if ( !mSpeculative ) {
+		debugout( "%s(%d) : %s\n", mName.c_str(), line, temp );
+	}
 
 	// only store the first error
 	if ( !HadError() ) {
 		char errorStr[512];
-		OT_SNPRINTF( errorStr, sizeof( errorStr ), "%s(%d) : %s", mName.c_str(), mLine, temp );
+		OT_SNPRINTF( errorStr, sizeof( errorStr ), "%s(%d) : %s", mName.c_str(), line, temp );
 		mErrorMsg = errorStr;
 	}
 
 	return false;
 }
 
-static bool IsNumeric( char const ch ) {
-	return ch >= '0' && ch <= '9';
-}
-
 static char PeekNext( char const * curPtr, char const * endPtr, char & next ) {
 	if ( curPtr + 1 >= endPtr ) {
 		return false;
@@ -242,183 +395,532 @@ static char PeekNext( char const * curPtr, char const * endPtr, char & next ) {
 	return true;
 }
 
-bool cLexer::IsNegativeNumber( cLexer::ePunctuation const punc, char const * curPtr, char const * endPtr ) const {
-	if ( punc != cLexer::PUNC_MINUS ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::IsNegativeNumber( ePunctuation const punc ) const {
+	if ( punc != PUNC_MINUS ) {
 		return false;
 	}
 	char nextCh;
-	if ( !PeekNext( curPtr, endPtr, nextCh ) ) {
+	if ( !PeekNext( mCur, mEnd, nextCh ) ) {
 		return false;
 	}
 	if ( IsNumeric( nextCh ) ) {
 		return true;
 	}
-	cLexer::ePunctuation const nextPunc = GetPunctuationType( nextCh );
-	return nextPunc == cLexer::PUNC_PERIOD;
+	ePunctuation const nextPunc = GetPunctuationType( nextCh );
+	return nextPunc == PUNC_PERIOD;
 }
 
-static bool IsNumberStartingWithDecimalPoint( cLexer::ePunctuation const punc, char const * curPtr, char const * endPtr ) {
-	if ( punc != cLexer::PUNC_PERIOD ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::IsNumberStartingWithDecimalPoint( ePunctuation const punc ) const {
+	if ( punc != PUNC_PERIOD ) {
 		return false;
 	}
 	char nextCh;
-	if ( !PeekNext( curPtr, endPtr, nextCh ) ) {
+	if ( !PeekNext( mCur, mEnd, nextCh ) ) {
 		return false;
 	}
 	return IsNumeric( nextCh );
 }
 
-bool cLexer::NextToken( cToken & token ) {
-	token.Clear();
-	token.SetFileIndex( mFileIndex );
-
+template< typename tProfile >
+void cLexerT< tProfile >::SkipWhitespaceAndComments() {
+	// a comment carried on from the last window comes before anything else
+	if ( mOpenComment != COMMENT_NONE ) {
+		SkipComments();
+		if ( OutOfText() ) {
+			return;
+		}
+	}
 	bool skipped;
 	do {
 		skipped = false;
 		skipped |= SkipWhitespace();
 		skipped |= SkipComments();
-	} while ( !AtEnd() && skipped );
+	} while ( !OutOfText() && skipped );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::IsNumberStart( ePunctuation const punc ) const {
+	return IsNumeric( *mCur ) || IsNegativeNumber( punc ) || IsNumberStartingWithDecimalPoint( punc );
+}
 
+template< typename tProfile >
+bool cLexerT< tProfile >::ScanString( ePunctuation const punc, sTokenView & view, char const * & start, char const * & end ) {
+	const int32_t openQuoteLine = mLine;
+	// a stream window may start part way along the line
+	const size_t openQuoteOffset = mCur - mLineStart + ( mLineStart == mText ? mHeldColumns : 0 );
+	// only the opening character has the quote's punctuation type, so it is also the closing one
+	char const quoteChar = *mCur;
+	mCur++;
+	char const * tokenStart = mCur;
+	// the string may span lines, so take the offset on the line it starts on now
+	const int32_t tokenLineOffset = static_cast< int32_t >( tokenStart - mLineStart );
+	char const * closeQuote = FindEither( mCur, mEnd, quoteChar, '\0' );
+	if ( TrackLines() ) {
+		mLine += CountNewlines( mCur, closeQuote, mLineStart );
+	}
+	mCur = closeQuote;
 	if ( AtEnd() ) {
-		return false;
+		if ( !TrackLines() ) {
+			char const * quoteLineStart = mText;
+			int32_t const quoteLine = CountNewlines( mText, tokenStart - 1, quoteLineStart );
+			return Error( "No closing quote found for open quote on line %i, offset %i", quoteLine,
+					static_cast< int >( tokenStart - 1 - quoteLineStart ) );
+		}
+		return Error( "No closing quote found for open quote on line %i, offset %i", openQuoteLine, openQuoteOffset );
 	}
+	mCur++;
+
+	view.mType = cToken::STRING;
+	view.mSubType = punc;
+	view.mLine = openQuoteLine;
+	view.mColumn = tokenLineOffset;
+	start = tokenStart;
+	end = mCur - 1;
+	return true;
+}
 
-	token.SetLine( mLine );
-
-	ePunctuation punc = GetPunctuationType( *mCur );
-	//char nextCh;
-	//const bool nextValid = PeekNext( mCur, mEnd, nextCh );
-	if ( punc == PUNC_QUOTE || punc == PUNC_SINGLE_QUOTE ) {
-		const int32_t openQuoteLine = mLine;
-		const size_t openQuoteOffset = mCur - mLineStart;
-		mCur++;
-		char const * tokenStart = mCur;
-		ePunctuation closeQuote = PUNC_MAX;
-		for ( ; ; ) {
-			if ( AtEnd() ) {
-				return Error( "No closing quote found for open quote on line %i, offset %i", openQuoteLine, openQuoteOffset );
-			}
-			if ( IsEndOfLine( *mCur ) ) {
-				mLine++;
-			} else {
-				closeQuote = GetPunctuationType( *mCur );
-			}
+template< typename tProfile >
+bool cLexerT< tProfile >::ScanNumber( sTokenView & view, char const * & start, char const * & end ) {
+	view.mType = cToken::NUMBER;
+	view.mSubType = cToken::INTEGER;
+	int numDecimals = 0;
+	int numMinuses = 0;
+	char const * tokenStart = mCur;
+
+	// hex integers are 0x or 0X, then hex digits
+	char const * digits = *mCur == '-' ? mCur + 1 : mCur;
+	if ( IsHexStart( digits, mEnd ) ) {
+		mCur = digits + 2;
+		while ( !AtEnd() && IsHexDigit( *mCur ) ) {
 			mCur++;
-			if ( closeQuote == punc ) {
-				break;
-			}
 		}
-
-		token.SetType( cToken::STRING );
-		token.SetSubType( punc );
-		token.SetText( tokenStart, mCur - tokenStart - 1 );
-		token.SetLine( openQuoteLine );
-		token.SetLineOffset( static_cast< int32_t >( tokenStart - mLineStart ) );
-		token.SetOffset( tokenStart - mText );
+		view.mLine = mLine;
+		view.mColumn = static_cast< uint32_t >( tokenStart - mLineStart );
+		start = tokenStart;
+		end = mCur;
 		return true;
-	} else if ( IsNumeric( *mCur ) || IsNegativeNumber( punc, mCur, mEnd ) || IsNumberStartingWithDecimalPoint( punc, mCur, mEnd ) ) {
-		token.SetType( cToken::NUMBER );
-		token.SetSubType( cToken::INTEGER );
-		int numDecimals = 0;
-		int numMinuses = 0;
-		char const * tokenStart = mCur;
-
-		while ( !AtEnd() ) {
-			// end of line terminates a token
-			// white space terminates a token
-			// comment start terminates a token
-			if ( IsEndOfLine( *mCur ) || IsWhitespace( *mCur ) || mCommentTypeFn( mFlags, *mCur, *( mCur + 1 ) ) != COMMENT_NONE ) {
-				break;
-			}
-			// Handle numbers terminated by f or L (double). This can never happen for the first character because
-			// in that case IsNumeric() is true.
-			if ( *mCur == 'f' || *mCur == 'F' || *mCur == 'l' || *mCur == 'L' ) {
-				// consume the character, but then were done
+	}
+
+	while ( !AtEnd() ) {
+		// end of line terminates a token
+		// white space terminates a token
+		// comment start terminates a token
+		if ( IsWhitespace( *mCur ) || IsCommentStart() ) {
+			break;
+		}
+		// Handle numbers terminated by f or L (double). This can never happen for the first character because
+		// in that case IsNumeric() is true.
+		if ( *mCur == 'f' || *mCur == 'F' || *mCur == 'l' || *mCur == 'L' ) {
+			// consume the character, but then were done
+			mCur++;
+			break;
+		}
+		// handle scientific notation format
+		if ( *mCur == 'e' || *mCur == 'E' || *mCur == 'l' || *mCur == 'L' ) {
+			// an exponent makes a float, as in C and Lua. Its sign is part of it, not another minus.
+			view.mSubType = cToken::FLOAT;
+			mCur++;
+			if ( !AtEnd() && ( *mCur == '+' || *mCur == '-' ) ) {
 				mCur++;
-				break;
 			}
-			// handle scientific notation format
-			if ( *mCur == 'e' || *mCur == 'E' || *mCur == 'l' || *mCur == 'L' ) {
-				mCur++;
-				continue;
+			continue;
+		}
+		// any punctutation other than a decimal point or minus terminates a number token
+		ePunctuation const curPunc = GetPunctuationType( *mCur );
+		if ( curPunc != PUNC_NONE && curPunc != PUNC_PERIOD && curPunc != PUNC_MINUS ) {
+			break;
+		}
+		if ( curPunc == PUNC_PERIOD ) {
+			numDecimals++;
+			view.mSubType = cToken::FLOAT;
+			if ( numDecimals > 1 ) {
+				return Error( "Invalid number format" );
 			}
-			// any punctutation other than a decimal point or minus terminates a number token
-			ePunctuation const curPunc = GetPunctuationType( *mCur );
-			if ( curPunc != PUNC_NONE && curPunc != PUNC_PERIOD && curPunc != PUNC_MINUS ) {
-				break;
+		} else if ( curPunc == PUNC_MINUS ) {
+			numMinuses++;
+			if ( numMinuses > 1 ) {
+				return Error( "Invalid number format" );
 			}
-			if ( curPunc == PUNC_PERIOD ) {
-				numDecimals++;
-				token.SetSubType( cToken::FLOAT );
-				if ( numDecimals > 1 ) {
-					return Error( "Invalid number format" );
-				}
-			} else if ( curPunc == PUNC_MINUS ) {
-				numMinuses++;
-				if ( numMinuses > 1 ) {
-					return Error( "Invalid number format" );
-				}
-			} else if ( !IsNumeric( *mCur ) ) {
-				// anything non-numeric terminates a number
+		} else if ( !IsNumeric( *mCur ) ) {
+			// anything non-numeric terminates a number
+			break;
+		}
+
+		mCur++;
+	}
+	if ( mCur > tokenStart ) {
+		view.mLine = mLine;
+		view.mColumn = static_cast< uint32_t >( tokenStart - mLineStart );
+		start = tokenStart;
+		end = mCur;
+		return true;
+	}
+	return false;
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::ScanName( sTokenView & view, char const * & start, char const * & end ) {
+	char const * tokenStart = mCur;
+	view.mType = cToken::NAME;
+	view.mSubType = 0;
+	// read until end of name
+	while ( !AtEnd() ) {
+		if constexpr ( tProfile::SCAN_AHEAD ) {
+			// letters, digits and '_' can't end a name, only what follows them needs checking
+			mCur = ScanNameChars( mCur, mEnd );
+			if ( AtEnd() ) {
 				break;
 			}
-
-			mCur++;
 		}
-		if ( mCur > tokenStart ) {
-			token.SetText( tokenStart, mCur - tokenStart );
-			token.SetLineOffset( static_cast< int32_t > ( tokenStart - mLineStart ) );
-			token.SetOffset( tokenStart - mText );
-			token.SetLine( mLine );
-			return true;
+		// punctuation terminates
+		const ePunctuation curPunc = GetPunctuationType( *mCur );
+		if ( curPunc != PUNC_NONE && ( mFlags & FLAG_ALLOW_PUNCTUATION_IN_NAMES ) == 0 ) {
+			break;
 		}
+		// end of line terminates a token
+		// white space terminates a token
+		// comment start terminates a token
+		if ( IsWhitespace( *mCur ) || IsCommentStart() ) {
+			break;
+		}
+
+		// consume the character
+		mCur++;
+	}
+	if ( mCur > tokenStart ) {
+		view.mLine = mLine;
+		view.mColumn = static_cast< uint32_t >( tokenStart - mLineStart );
+		start = tokenStart;
+		end = mCur;
+		return true;
+	}
+	return false;
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::LexToken( sTokenView & view, char const * & start, char const * & end ) {
+	SkipWhitespaceAndComments();
+	if ( OutOfText() ) {
+		return false;
 	}
-	else if ( punc != PUNC_NONE ) {
-		char const p = *mCur;
+
+	ePunctuation const punc = GetPunctuationType( *mCur );
+	if ( punc == PUNC_QUOTE || punc == PUNC_SINGLE_QUOTE ) {
+		return ScanString( punc, view, start, end );
+	} else if ( IsNumberStart( punc ) ) {
+		return ScanNumber( view, start, end );
+	} else if ( punc != PUNC_NONE ) {
+		view.mType = cToken::PUNCTUATION;
+		view.mSubType = punc;
+		view.mLine = mLine;
+		view.mColumn = static_cast< uint32_t >( mCur - mLineStart );
+		start = mCur;
 		mCur++; // consume the punctuation
-		token.SetType( cToken::PUNCTUATION );
-		token.SetSubType( punc );
-		token.SetLineOffset( static_cast< int32_t > ( mCur - mLineStart ) );
-		token.SetOffset( mCur - mText );
-		token.SetLine( mLine );
-		char text[2];
-		text[0] = p;
-		text[1] = '\0';
-		token.SetText( text, 1 );
+		end = mCur;
 		return true;
+	}
+	return ScanName( view, start, end );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::LexName( sTokenView & view, char const * & start, char const * & end ) {
+	for ( ; ; ) {
+		SkipWhitespaceAndComments();
+		if ( OutOfText() ) {
+			return false;
+		}
+
+		// everything but names is stepped over, stopping only where NextToken would have
+		ePunctuation const punc = GetPunctuationType( *mCur );
+		if ( punc == PUNC_QUOTE || punc == PUNC_SINGLE_QUOTE ) {
+			if ( !ScanString( punc, view, start, end ) ) {
+				return false;
+			}
+		} else if ( IsNumberStart( punc ) ) {
+			if ( !ScanNumber( view, start, end ) ) {
+				return false;
+			}
+		} else if ( punc != PUNC_NONE ) {
+			mCur++;
+		} else {
+			return ScanName( view, start, end );
+		}
+	}
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextName( sTokenView & view ) {
+	DropLookahead();
+	char const * start;
+	char const * end;
+	if ( !LexName( view, start, end ) ) {
+		return false;
+	}
+	return FinishView( start, end, view );
+}
+
+template< typename tProfile >
+void cLexerT< tProfile >::MakeToken( sTokenView const & view, char const * start, char const * end, cToken & token ) const {
+	token.SetType( static_cast< cToken::eTokenType >( view.mType ) );
+	// names leave the subtype as it was
+	if ( view.mType != cToken::NAME ) {
+		token.SetSubType( view.mSubType );
+	}
+	token.SetText( start, end - start );
+	if ( view.mType == cToken::NUMBER ) {
+		ParseNumber( start, end, view.mSubType, token );
+	}
+	token.SetLine( view.mLine );
+	if ( view.mType == cToken::PUNCTUATION ) {
+		// punctuation has always been placed just past its character
+		token.SetLineOffset( view.mColumn + 1 );
+		token.SetOffset( start - mText + 1 );
 	} else {
-		char const * tokenStart = mCur;
-		token.SetType( cToken::NAME );
-		// read until end of name
-		while ( !AtEnd() ) {
-			// punctuation terminates
-			const ePunctuation curPunc = GetPunctuationType( *mCur );
-			if ( curPunc != PUNC_NONE && ( mFlags & FLAG_ALLOW_PUNCTUATION_IN_NAMES ) == 0 ) {
+		token.SetLineOffset( view.mColumn );
+		token.SetOffset( start - mText );
+	}
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextToken( cToken & token ) {
+	token.Clear();
+	token.SetFileIndex( mFileIndex );
+
+	if ( mLookaheadCount > 0 ) {
+		sLookahead const & next = mLookahead[mLookaheadFirst];
+		MakeToken( next.mView, next.mStart, next.mEnd, token );
+		mLookaheadFirst = ( mLookaheadFirst + 1 ) % LOOKAHEAD_SIZE;
+		mLookaheadCount--;
+		return true;
+	}
+
+	sTokenView view;
+	char const * start;
+	char const * end;
+	if ( !LexToken( view, start, end ) ) {
+		return false;
+	}
+	MakeToken( view, start, end, token );
+	return true;
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextToken( sTokenView & view ) {
+	DropLookahead();
+	char const * start;
+	char const * end;
+	if ( !LexToken( view, start, end ) ) {
+		return false;
+	}
+	return FinishView( start, end, view );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::FinishView( char const * start, char const * end, sTokenView & view ) const {
+	if ( static_cast< size_t >( end - start ) > sTokenView::MAX_LENGTH ) {
+		return Error( "Token is longer than %u characters", sTokenView::MAX_LENGTH );
+	}
+	if ( static_cast< size_t >( start - mText ) > UINT32_MAX ) {
+		return Error( "Token is too far into the text for a token view" );
+	}
+	view.mOffset = static_cast< uint32_t >( start - mText );
+	view.mLength = static_cast< uint32_t >( end - start );
+	return true;
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextTokens( sTokenBatch & batch ) {
+	batch.mCount = 0;
+	DropLookahead();
+	// like NextToken, nothing more comes after an error
+	if ( HadError() ) {
+		return false;
+	}
+	// when only names are wanted nothing else needs to be built
+	bool const namesOnly = batch.mTypeMask == sTokenBatch::TypeBit( cToken::NAME );
+	sTokenView view;
+	char const * start;
+	char const * end;
+	while ( batch.mCount < batch.mCapacity && ( namesOnly ? LexName( view, start, end ) : LexToken( view, start, end ) ) ) {
+		if ( ( batch.mTypeMask & sTokenBatch::TypeBit( static_cast< cToken::eTokenType >( view.mType ) ) ) == 0 ) {
+			continue;
+		}
+		if ( static_cast< size_t >( end - mText ) > UINT32_MAX ) {
+			Error( "Token is too far into the text for a token batch" );
+			break;
+		}
+		size_t const i = batch.mCount++;
+		batch.mTypes[i] = static_cast< uint8_t >( view.mType );
+		batch.mOffsets[i] = static_cast< uint32_t >( start - mText );
+		batch.mLengths[i] = static_cast< uint32_t >( end - start );
+		if ( batch.mLines != nullptr ) {
+			batch.mLines[i] = view.mLine;
+		}
+	}
+	return batch.mCount > 0;
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextView( sTokenView & view, uint32_t const typeMask ) {
+	bool const namesOnly = typeMask == sTokenBatch::TypeBit( cToken::NAME );
+	char const * start;
+	char const * end;
+	do {
+		if ( !( namesOnly ? LexName( view, start, end ) : LexToken( view, start, end ) ) ) {
+			return false;
+		}
+	} while ( ( typeMask & sTokenBatch::TypeBit( static_cast< cToken::eTokenType >( view.mType ) ) ) == 0 );
+	return FinishView( start, end, view );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextTokensParallel( std::vector< sTokenView > & views, uint32_t const numThreads, 
+		uint32_t const typeMask ) {
+	if ( HadError() ) {
+		return false;
+	}
+	DropLookahead();
+	size_t const remaining = mEnd - mCur;
+	size_t const maxChunks = std::min< size_t >( numThreads, remaining / PARALLEL_MIN_CHUNK_SIZE );
+
+	// every chunk starts at the start of a line, so a lexer started there has its line offsets right
+	std::vector< char const * > starts( 1, mCur );
+	for ( size_t k = 1; k < maxChunks; ++k ) {
+		char const * p = mCur + remaining * k / maxChunks;
+		char const * nl = static_cast< char const * >( memchr( p, '\n', mEnd - p ) );
+		if ( nl == nullptr || nl + 1 >= mEnd ) {
+			break;
+		}
+		if ( nl + 1 > starts.back() ) {
+			starts.push_back( nl + 1 );
+		}
+	}
+	size_t const numChunks = starts.size();
+	if ( numChunks < 2 ) {
+		sTokenView view;
+		while ( NextView( view, typeMask ) ) {
+			views.push_back( view );
+		}
+		return !HadError();
+	}
+	starts.push_back( mEnd );
+
+	// where lexing of a view's token began, which for strings is the opening quote
+	auto tokenStart = []( sTokenView const & view ) -> size_t {
+		return view.mType == cToken::STRING ? view.mOffset - 1 : view.mOffset;
+	};
+
+	auto runChunks = [&]( auto const & fn ) {
+		std::vector< std::thread > threads;
+		for ( size_t k = 1; k < numChunks; ++k ) {
+			threads.emplace_back( fn, k );
+		}
+		fn( 0 );
+		for ( std::thread & t : threads ) {
+			t.join();
+		}
+	};
+
+	// count the lines first, so each chunk's lexer starts out on the right line
+	std::vector< int32_t > lines( numChunks, mLine );
+	if ( TrackLines() ) {
+		std::vector< int32_t > counts( numChunks );
+		runChunks( [&]( size_t const k ) {
+			char const * lineStart;
+			counts[k] = CountNewlines( starts[k], starts[k + 1], lineStart );
+		} );
+		for ( size_t k = 1; k < numChunks; ++k ) {
+			lines[k] = lines[k - 1] + counts[k - 1];
+		}
+	}
+
+	// each chunk lexes the tokens starting inside it as if a token started at its start. The first token
+	// past its end is kept too, in case lexing carries on from this chunk into the next.
+	struct sChunk {
+		std::unique_ptr< cLexerT >	mLexer;
+		std::vector< sTokenView >	mViews;
+		sTokenView					mNext;
+		bool						mHasNext = false;
+	};
+	std::vector< sChunk > chunks( numChunks );
+	for ( size_t k = 1; k < numChunks; ++k ) {
+		chunks[k].mLexer.reset( new cLexerT( *this, starts[k], lines[k] ) );
+		chunks[k].mLexer->mSpeculative = true;
+	}
+	runChunks( [&]( size_t const k ) {
+		sChunk & chunk = chunks[k];
+		cLexerT & lexer = k == 0 ? *this : *chunk.mLexer;
+		size_t const limit = starts[k + 1] - mText;
+		sTokenView view;
+		while ( lexer.NextView( view, typeMask ) ) {
+			if ( k + 1 < numChunks && tokenStart( view ) >= limit ) {
+				chunk.mNext = view;
+				chunk.mHasNext = true;
 				break;
 			}
-			// end of line terminates a token
-			// white space terminates a token
-			// comment start terminates a token
-			if ( IsEndOfLine( *mCur ) || IsWhitespace( *mCur ) || mCommentTypeFn( mFlags, *mCur, *( mCur + 1 ) ) != COMMENT_NONE ) {
+			chunk.mViews.push_back( view );
+		}
+	} );
+
+	// Only the first chunk started from the real state. Carry the real lexer on into the next chunk until
+	// it reaches a token that chunk also started; from there the two lex the same, so the chunk's tokens
+	// are taken as they are and its lexer becomes the real one.
+	views.insert( views.end(), chunks[0].mViews.begin(), chunks[0].mViews.end() );
+	cLexerT * lexer = this;
+	sTokenView next = chunks[0].mNext;
+	bool hasNext = chunks[0].mHasNext;
+	for ( size_t k = 1; k < numChunks && hasNext; ++k ) {
+		sChunk & chunk = chunks[k];
+		size_t const limit = starts[k + 1] - mText;
+		size_t i = 0;
+		for ( ; ; ) {
+			size_t const nextStart = tokenStart( next );
+			while ( i < chunk.mViews.size() && tokenStart( chunk.mViews[i] ) < nextStart ) {
+				i++;
+			}
+			if ( i < chunk.mViews.size() && tokenStart( chunk.mViews[i] ) == nextStart ) {
+				views.insert( views.end(), chunk.mViews.begin() + i, chunk.mViews.end() );
+				lexer = chunk.mLexer.get();
+				next = chunk.mNext;
+				hasNext = chunk.mHasNext;
+				break;
+			}
+			if ( k + 1 < numChunks && nextStart >= limit ) {
+				// never met the chunk's tokens, its lexer guessed wrong all the way through
+				break;
+			}
+			views.push_back( next );
+			hasNext = lexer->NextView( next, typeMask );
+			if ( !hasNext ) {
 				break;
 			}
-
-			// consume the character
-			mCur++;
 		}
-		if ( mCur > tokenStart ) {
-			token.SetText( tokenStart, mCur - tokenStart );
-			token.SetLineOffset( static_cast< int32_t > ( tokenStart - mLineStart ) );
-			token.SetOffset( tokenStart - mText );
-			token.SetLine( mLine );
-			return true;
+	}
+
+	if ( lexer != this ) {
+		mCur = lexer->mCur;
+		mLineStart = lexer->mLineStart;
+		mLine = lexer->mLine;
+		mErrorMsg = lexer->mErrorMsg;
+		if ( HadError() ) {
+			// held back while it might not have been real
+			debugout( "%s\n", mErrorMsg.c_str() );
 		}
 	}
-	return false;
+	return !HadError();
 }
 
-bool cLexer::NextToken( cToken & token, cErrorHandler & errorHandler ) {
-	bool wasAtEnd = AtEnd();
+template< typename tProfile >
+void cLexerT< tProfile >::CopyToToken( sTokenView const & view, cToken & token ) const {
+	token.SetFileIndex( mFileIndex );
+	MakeToken( view, GetText( view ), GetText( view ) + view.mLength, token );
+}
+
+template< typename tProfile >
+bool cLexerT< tProfile >::NextToken( cToken & token, cErrorHandler & errorHandler ) {
+	bool wasAtEnd = mLookaheadCount == 0 && AtEnd();
 	if ( wasAtEnd ) {
 		token.Clear();
 		return false;
@@ -433,22 +935,63 @@ bool cLexer::NextToken( cToken & token, cErrorHandler & errorHandler ) {
 	return r;
 }
 
-bool cLexer::PeekNextToken( cToken & token ) {
-	char const * savedCur = mCur;
-	char const * savedLineStart = mLineStart;
-	int32_t savedLine = mLine;
+template< typename tProfile >
+bool cLexerT< tProfile >::LexAhead() {
+	sLookahead & next = mLookahead[( mLookaheadFirst + mLookaheadCount ) % LOOKAHEAD_SIZE];
+	next.mCur = mCur;
+	next.mLineStart = mLineStart;
+	next.mLine = mLine;
+	if ( !LexToken( next.mView, next.mStart, next.mEnd ) ) {
+		// back to the start, so taking the token fails in the same way
+		mCur = next.mCur;
+		mLineStart = next.mLineStart;
+		mLine = next.mLine;
+		return false;
+	}
+	mLookaheadCount++;
+	return true;
+}
+
+template< typename tProfile >
+void cLexerT< tProfile >::DropLookahead() {
+	if ( mLookaheadCount == 0 ) {
+		return;
+	}
+	sLookahead const & next = mLookahead[mLookaheadFirst];
+	mCur = next.mCur;
+	mLineStart = next.mLineStart;
+	mLine = next.mLine;
+	mLookaheadFirst = 0;
+	mLookaheadCount = 0;
+}
 
-	const bool r = NextToken( token );
-	
-	mCur = savedCur;
-	mLineStart = savedLineStart;
-	mLine = savedLine;
+template< typename tProfile >
+bool cLexerT< tProfile >::PeekNextToken( cToken & token ) {
+	return PeekNextToken( 0, token );
+}
 
-	return r;
+template< typename tProfile >
+bool cLexerT< tProfile >::PeekNextToken( uint32_t const n, cToken & token ) {
+	token.Clear();
+	token.SetFileIndex( mFileIndex );
+
+	OTTER_ASSERT( n < LOOKAHEAD_SIZE );
+	if ( n >= LOOKAHEAD_SIZE ) {
+		return false;
+	}
+	while ( mLookaheadCount <= n ) {
+		if ( !LexAhead() ) {
+			return false;
+		}
+	}
+	sLookahead const & peeked = mLookahead[( mLookaheadFirst + n ) % LOOKAHEAD_SIZE];
+	MakeToken( peeked.mView, peeked.mStart, peeked.mEnd, token );
+	return true;
 }
 
-bool cLexer::PeekNextToken( cToken & token, cErrorHandler & errorHandler ) {
-	bool wasAtEnd = AtEnd();
+template< typename tProfile >
+bool cLexerT< tProfile >::PeekNextToken( cToken & token, cErrorHandler & errorHandler ) {
+	bool wasAtEnd = mLookaheadCount == 0 && AtEnd();
 	if ( wasAtEnd ) {
 		token.Clear();
 		return false;
@@ -462,19 +1005,22 @@ bool cLexer::PeekNextToken( cToken & token, cErrorHandler & errorHandler ) {
 	return true;
 }
 
-bool cLexer::ExpectName( cToken & token ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectName( cToken & token ) {
 	bool const r = NextToken( token );
 	return ( r && token.GetType() == cToken::NAME );
 }
 
-bool cLexer::ExpectName( cToken & token, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectName( cToken & token, cErrorHandler & errorHandler ) {
 	if ( !ExpectName( token ) ) {
 		return errorHandler.Error( "Expected a name, got a %s.", cToken::GetTokenTypeName( token.GetType() ) );
 	}
 	return true;
 }
 
-bool cLexer::ExpectName( char const * str, cToken & token ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectName( char const * str, cToken & token ) {
 	bool const r = NextToken( token );
 	if ( r && token.GetType() == cToken::NAME ) {
 		if ( ( mFlags & FLAG_IGNORE_CASE ) != 0 ) {
@@ -486,62 +1032,70 @@ bool cLexer::ExpectName( char const * str, cToken & token ) {
 	return false;
 }
 
-bool cLexer::ExpectName( char const * str, cToken & token, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectName( char const * str, cToken & token, cErrorHandler & errorHandler ) {
 	if ( !ExpectName( str, token ) ) {
 		return errorHandler.Error( "Expected name '%s', got '%s'.", str, token.GetText() );
 	}
 	return true;
 }
 
-bool cLexer::ExpectDouble( cToken & token, double & f ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectDouble( cToken & token, double & f ) {
 	bool const r = NextToken( token );
 	if ( !r || token.GetType() != cToken::NUMBER ) {
 		return false;
 	}
-	f = strtod( token.GetText(), nullptr );
+	f = token.GetNumber();
 	return true;
 }
 
-bool cLexer::ExpectDouble( cToken & token, double & f, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectDouble( cToken & token, double & f, cErrorHandler & errorHandler ) {
 	if ( !ExpectDouble( token, f ) ) {
 		return errorHandler.Error( "Expected double, got '%s'.", cToken::GetTokenTypeName( token.GetType() ) );
 	}
 	return true;
 }
 
-bool cLexer::ExpectFloat( cToken & token, float & f ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectFloat( cToken & token, float & f ) {
 	bool const r = NextToken( token );
 	if ( !r || token.GetType() != cToken::NUMBER ) {
 		return false;
 	}
-	f = strtof( token.GetText(), nullptr );
+	f = static_cast< float >( token.GetNumber() );
 	return true;
 }
 
-bool cLexer::ExpectFloat( cToken & token, float & f, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectFloat( cToken & token, float & f, cErrorHandler & errorHandler ) {
 	if ( !ExpectFloat( token, f ) ) {
 		return errorHandler.Error( "Expected float, got '%s'.", cToken::GetTokenTypeName( token.GetType() ) );
 	}
 	return true;
 }
 
-bool cLexer::ExpectInteger( cToken & token, int32_t & i ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectInteger( cToken & token, int32_t & i ) {
 	bool const r = NextToken( token );
 	if ( !r || token.GetType() != cToken::NUMBER || token.GetSubType() != cToken::INTEGER ) {
 		return false;
 	}
-	i = strtol( token.GetText(), nullptr, 10 );
+	i = static_cast< int32_t >( token.GetInteger() );
 	return true;
 }
 
-bool cLexer::ExpectInteger( cToken & token, int32_t & i, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectInteger( cToken & token, int32_t & i, cErrorHandler & errorHandler ) {
 	if ( !ExpectInteger( token, i ) ) {
 		return errorHandler.Error( "Expected integer, got %s.", cToken::GetTokenTypeName( token.GetType() ) );
 	}
 	return true;
 }
 
-bool cLexer::ExpectPunctuation( cToken & token, ePunctuation & punc ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectPunctuation( cToken & token, ePunctuation & punc ) {
 	bool const r = NextToken( token );
 	if ( !r || token.GetType() != cToken::PUNCTUATION ) {
 		return false;
@@ -550,14 +1104,16 @@ bool cLexer::ExpectPunctuation( cToken & token, ePunctuation & punc ) {
 	return true;
 }
 
-bool cLexer::ExpectPunctuation( cToken & token, ePunctuation & punc, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectPunctuation( cToken & token, ePunctuation & punc, cErrorHandler & errorHandler ) {
 	if ( !ExpectPunctuation( token, punc ) ) {
 		return errorHandler.Error( "Expected punctuation, got %s.", cToken::GetTokenTypeName( token.GetType() ) );
 	}
 	return true;
 }
 
-bool cLexer::ExpectPunctuation( ePunctuation const punc, cToken & token ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectPunctuation( ePunctuation const punc, cToken & token ) {
 	bool const r = NextToken( token );
 	if ( !r || token.GetType() != cToken::PUNCTUATION ) {
 		return false;
@@ -565,7 +1121,8 @@ bool cLexer::ExpectPunctuation( ePunctuation const punc, cToken & token ) {
 	return ( token.GetSubType() == punc );
 }
 
-bool cLexer::ExpectPunctuation( ePunctuation const punc, cToken & token, cErrorHandler & errorHandler ) {
+template< typename tProfile >
+bool cLexerT< tProfile >::ExpectPunctuation( ePunctuation const punc, cToken & token, cErrorHandler & errorHandler ) {
 	if ( !ExpectPunctuation( punc, token ) ) {
 		if ( token.GetType() == cToken::PUNCTUATION ) {
 			ePunctuation p = static_cast< ePunctuation >( token.GetSubType() );
@@ -577,4 +1134,9 @@ bool cLexer::ExpectPunctuation( ePunctuation const punc, cToken & token, cErrorH
 	return true;
 }
 
+template class cLexerT< cRuntimeLexerProfile >;
+template class cLexerT< sCLexerProfile >;
+template class cLexerT< sHashLexerProfile >;
+template class cLexerT< sLuaLexerProfile >;
+
 } // namespace otter
\ No newline at end of file
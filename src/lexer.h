@@ -1,7 +1,9 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 #include <strings.h>
 #include "charbuffer.h"
 
@@ -32,7 +34,9 @@ public:
 		, mFileIndex( -1 )
 		, mLine( -1 )
 		, mLineOffset( -1 )
-		, mOffset( 0 ) {
+		, mOffset( 0 )
+		, mNumber( 0.0 )
+		, mInteger( 0 ) {
 	}
 	virtual ~cToken() {
 	}
@@ -59,6 +63,11 @@ public:
 	size_t					GetOffset() const { return mOffset; }
 	void					SetOffset( size_t const ofs ) { mOffset = ofs; }
 
+	// the value of a NUMBER token, parsed as it was lexed. For a FLOAT the integer is the value truncated.
+	double					GetNumber() const { return mNumber; }
+	int64_t					GetInteger() const { return mInteger; }
+	void					SetNumber( double const number, int64_t const integer ) { mNumber = number; mInteger = integer; }
+
 	void					Clear() { SetText( "", 0 ); }
 
 	bool					IsValid() const { return mType != NONE; }
@@ -99,6 +108,8 @@ private:
 	int32_t		mLine;
 	int32_t		mLineOffset;	// offset on the line
 	size_t		mOffset;		// offset in the file
+	double		mNumber;		// only set for NUMBER tokens
+	int64_t		mInteger;
 };
 
 //==============================================================
@@ -151,10 +162,8 @@ public:
 			mText = "";
 			return;
 		}
-		char t[len + 1];
-		OT_STRNCPY( t, len + 1, text, len );
-		t[len] = '\0';
-		mText = t;
+		// like OT_STRNCPY, stop at a zero-terminator inside len
+		mText.assign( text, strnlen( text, len ) );
 	}
 
 	operator const char*() const { return mText.c_str(); }
@@ -164,17 +173,141 @@ private:
 };
 
 //==============================================================
-// cLexer
+// sTokenView
 //
-// NOTE: this does not support UTF8 or Unicode
+// A token as a span of the lexer's text: nothing is copied, so it stays
+// valid only as long as that text does. Offsets and columns point at the
+// token's first character (for strings, the one after the opening quote),
+// unlike cToken's punctuation, which points one past it.
+//==============================================================
+struct sTokenView {
+	static constexpr uint32_t	MAX_LENGTH = ( 1u << 22 ) - 1;
+
+	uint32_t	mOffset;			// offset in the text
+	uint32_t	mLine;
+	uint32_t	mColumn;			// offset on the line
+	uint32_t	mLength : 22;
+	uint32_t	mType : 3;			// cToken::eTokenType
+	uint32_t	mSubType : 7;		// ePunctuation of punctuation and strings, eNumberSubType of numbers, 0 for names
+};
+
+static_assert( sizeof( sTokenView ) == 16, "sTokenView should be 16 bytes" );
+
+//==============================================================
+// sTokenBatch
+//
+// Arrays the caller owns, each mCapacity long, that NextTokens fills
+// with one entry per token, so tokens can be walked as flat arrays.
+// Offsets and lines are as in sTokenView.
+//==============================================================
+struct sTokenBatch {
+	static constexpr uint32_t	TypeBit( cToken::eTokenType const type ) { return 1u << type; }
+	static constexpr uint32_t	ALL_TYPES = ( 1u << cToken::MAX_TOKEN_TYPE ) - 1;
+
+	uint8_t *	mTypes = nullptr;		// cToken::eTokenType
+	uint32_t *	mOffsets = nullptr;
+	uint32_t *	mLengths = nullptr;
+	uint32_t *	mLines = nullptr;			// may be nullptr, e.g. with FLAG_NO_LINES
+	size_t		mCapacity = 0;
+	size_t		mCount = 0;				// how many tokens the last NextTokens filled in
+	uint32_t	mTypeMask = ALL_TYPES;	// TypeBit of each type to keep, the rest are lexed but dropped
+};
+
+//==============================================================
+// cLineIndex
+//
+// Where every line of a text starts, so a lexer run with FLAG_NO_LINES
+// can turn offsets back into lines and columns for the few tokens that
+// are reported.
+//==============================================================
+class cLineIndex {
+public:
+	cLineIndex() {
+	}
+	cLineIndex( char const * text, size_t const len ) {
+		Build( text, len );
+	}
+
+	void		Build( char const * text, size_t const len );
+
+	// 0-based, like the lexer's lines
+	int32_t		GetLine( size_t const offset ) const;
+	// the offset on its line
+	int32_t		GetLineOffset( size_t const offset ) const;
+
+private:
+	std::vector< size_t >	mNewlines;	// offset of every '\n', in order
+};
+
+//==============================================================
+// sLexerCharTable
+//
+// What every byte means to the lexer, looked up in one step instead
+// of a chain of comparisons.
 //==============================================================
-class cLexer {
+struct sLexerCharTable {
+	enum eCharClass : uint8_t {
+		CHAR_WHITESPACE		= ( 1 << 0 ),	// ' ', '\t', '\r' or '\n'
+		CHAR_DIGIT			= ( 1 << 1 ),	// '0' - '9'
+		CHAR_PUNCTUATION	= ( 1 << 2 ),	// one of the lexer's punctuation characters
+		CHAR_COMMENT		= ( 1 << 3 ),	// may start a comment, the profile has the final say
+	};
+
+	int8_t		mPunctuation[256];	// the ePunctuation of each character
+	uint8_t		mClass[256];		// eCharClass bits of each character
+};
+
+// builds the table for a punctuation string and the characters that can start a comment
+constexpr sLexerCharTable MakeLexerCharTable( char const * punctuation, char const * commentStarts ) {
+	sLexerCharTable table = {};
+	for ( int i = 0; i < 256; ++i ) {
+		table.mPunctuation[i] = -1;
+	}
+	table.mClass[static_cast< uint8_t >( ' ' )] |= sLexerCharTable::CHAR_WHITESPACE;
+	table.mClass[static_cast< uint8_t >( '\t' )] |= sLexerCharTable::CHAR_WHITESPACE;
+	table.mClass[static_cast< uint8_t >( '\r' )] |= sLexerCharTable::CHAR_WHITESPACE;
+	table.mClass[static_cast< uint8_t >( '\n' )] |= sLexerCharTable::CHAR_WHITESPACE;
+	for ( char ch = '0'; ch <= '9'; ++ch ) {
+		table.mClass[static_cast< uint8_t >( ch )] |= sLexerCharTable::CHAR_DIGIT;
+	}
+	for ( int i = 0; punctuation[i] != '\0'; ++i ) {
+		uint8_t const ch = static_cast< uint8_t >( punctuation[i] );
+		// the first occurrence wins
+		if ( table.mPunctuation[ch] == -1 ) {
+			table.mPunctuation[ch] = static_cast< int8_t >( i );
+		}
+		table.mClass[ch] |= sLexerCharTable::CHAR_PUNCTUATION;
+	}
+	for ( int i = 0; commentStarts[i] != '\0'; ++i ) {
+		table.mClass[static_cast< uint8_t >( commentStarts[i] )] |= sLexerCharTable::CHAR_COMMENT;
+	}
+	return table;
+}
+
+// true if no letter, digit or '_' is punctuation or a comment start, so names can be scanned ahead over them
+constexpr bool HasPlainNameChars( sLexerCharTable const & table ) {
+	for ( int i = 0; i < 256; ++i ) {
+		bool const nameChar = ( i >= 'a' && i <= 'z' ) || ( i >= 'A' && i <= 'Z' ) || ( i >= '0' && i <= '9' ) || i == '_';
+		if ( nameChar && ( table.mClass[i] & ( sLexerCharTable::CHAR_PUNCTUATION | sLexerCharTable::CHAR_COMMENT ) ) != 0 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//==============================================================
+// cLexerBase
+//
+// Types shared by every lexer, whatever its profile.
+//==============================================================
+class cLexerBase {
 public:
 	enum eFlags {
 		// FLAG_HASH_COMMENTS				= ( 1 << 0 ),	// treat # as starting a single-line comment
 		FLAG_IGNORE_CASE				= ( 1 << 1 ),	// use case insensitive compare for names
 		FLAG_ALLOW_PUNCTUATION_IN_NAMES	= ( 1 << 2 ),	// don't stop parsing a name token when punctuation is encountered
 		// FLAG_NO_SINGLE_LINE_C_COMMENTS	= ( 1 << 3 ),	// don't treat // as a single-line comment
+		FLAG_NO_LINES					= ( 1 << 4 ),	// don't count lines, tokens get line 0 and their offset as line offset (see cLineIndex)
 	};
 
 	enum ePunctuation {
@@ -237,17 +370,70 @@ public:
 		int32_t			mFileIndex = -1;
 	};
 
-	cLexer( char const * name, char const * text, size_t const len, const uint32_t flags = 0 );
-	cLexer( char const * name, char const * text, size_t const len, const sInitParms & initParms );
-	~cLexer();
+	// the punctuation used unless a cLexer is given its own
+	static constexpr char const *	DEFAULT_PUNCTUATION = "!~.,=?<>:;()[]{}|/\\+-*&^%$#@\"\'";
+};
+
+//==============================================================
+// cLexerT
+//
+// The lexer, with comment rules and character classes supplied at
+// compile time by a profile (see lexerprofiles.h), so the per-character
+// checks inline into the scanning loops. A profile provides:
+//
+//   sLexerCharTable const &	GetCharTable() const;
+//   eCommentType				GetCommentType( flags, curChar, nextChar ) const;
+//   bool						IsCommentEnd( flags, commentType, curChar, nextChar ) const;
+//
+// cLexer is the same lexer with the rules picked at run time.
+//
+// NOTE: this does not support UTF8 or Unicode
+//==============================================================
+template< typename tProfile >
+class cLexerT : public cLexerBase {
+public:
+	// how many tokens PeekNextToken can look ahead
+	static constexpr uint32_t	LOOKAHEAD_SIZE = 8;
+
+	// only mFlags and mFileIndex of initParms are used, the rest is up to the profile
+	cLexerT( char const * name, char const * text, size_t const len, const uint32_t flags = 0 );
+	cLexerT( char const * name, char const * text, size_t const len, const sInitParms & initParms );
+
+	cLexerT( cLexerT const & other ) = delete;
+	cLexerT & operator = ( cLexerT const & rhs ) = delete;
+
+	template< typename > friend class cStreamLexerT;
 
 	bool				Error( char const * fmt, ... ) const;
 
 	bool				NextToken( cToken & token );
 	bool				NextToken( cToken & token, cErrorHandler & errorHandler );
+	// never allocates; fails with an error for a token too long or too far into the text for a sTokenView
+	bool				NextToken( sTokenView & view );
+
+	// the next name, stepping over strings, numbers and punctuation without making tokens of them
+	bool				NextName( sTokenView & view );
 
+	// fills batch with the next tokens of the types in its mask, false if there were none before
+	// the end of the text or an error
+	bool				NextTokens( sTokenBatch & batch );
+
+	// appends the rest of the tokens of the types in typeMask (see sTokenBatch) to views, lexing chunks of
+	// the text on up to numThreads threads. The tokens, lines included, and any error are exactly what
+	// NextToken( sTokenView & ) would have given. false if lexing stopped on an error.
+	bool				NextTokensParallel( std::vector< sTokenView > & views, uint32_t const numThreads, 
+								uint32_t const typeMask = sTokenBatch::ALL_TYPES );
+
+	// the text of a view from NextToken, not zero-terminated
+	char const *		GetText( sTokenView const & view ) const { return mText + view.mOffset; }
+	// copies a view from NextToken into a token, as NextToken( cToken & ) would have filled it
+	void				CopyToToken( sTokenView const & view, cToken & token ) const;
+
+	// tokens peeked at are kept, so NextToken and the Expect functions take them without lexing them again
 	bool				PeekNextToken( cToken & token );
 	bool				PeekNextToken( cToken & token, cErrorHandler & errorHandler );
+	// the token n after the next one, so 0 is the next token; n must be less than LOOKAHEAD_SIZE
+	bool				PeekNextToken( uint32_t const n, cToken & token );
 
 	bool				ExpectName( cToken & token );
 	bool				ExpectName( cToken & token, cErrorHandler & errorHandler );
@@ -269,29 +455,82 @@ public:
 	bool				ExpectPunctuation( ePunctuation const punc, cToken & token );
 	bool				ExpectPunctuation( ePunctuation const punc, cToken & token, cErrorHandler & errorHandler );
 
-	int32_t				GetLine() const { return mLine; }
+	// the line after the last token taken, tokens only peeked at don't count. With FLAG_NO_LINES this counts
+	// the lines up to that position.
+	int32_t				GetLine() const;
 
 	bool				HadError() const { return !mErrorMsg.empty(); }
 	std::string const &	GetError() const { return mErrorMsg; }
 
-	char				GetPunctuationName( ePunctuation const punc );
+	char				GetPunctuationName( ePunctuation const punc ) const;
+
+protected:
+	tProfile			mProfile;
 
 private:
-	void				BuildPunctuationTable( const char * punctuation );
-	ePunctuation		GetPunctuationType( const char ch ) const;
-	bool 				IsNegativeNumber( cLexer::ePunctuation const punc, char const * curPtr, char const * endPtr ) const;
+	// chunks smaller than this aren't worth a thread
+	static constexpr size_t	PARALLEL_MIN_CHUNK_SIZE = 1 << 20;
+
+	// a lexer over the same text as other, starting at cur, which is the start of the given line
+	cLexerT( cLexerT const & other, char const * cur, int32_t const line );
+
+	uint8_t				GetCharClass( const char ch ) const { return mProfile.GetCharTable().mClass[static_cast< uint8_t >( ch )]; }
+	ePunctuation		GetPunctuationType( const char ch ) const {
+		return static_cast< ePunctuation >( mProfile.GetCharTable().mPunctuation[static_cast< uint8_t >( ch )] );
+	}
+	bool				IsWhitespace( const char ch ) const { return ( GetCharClass( ch ) & sLexerCharTable::CHAR_WHITESPACE ) != 0; }
+	bool				IsNumeric( const char ch ) const { return ( GetCharClass( ch ) & sLexerCharTable::CHAR_DIGIT ) != 0; }
+	// the character after the current one, or '\0' past the end of the text
+	char				PeekChar() const { return mCur + 1 < mEnd ? *( mCur + 1 ) : '\0'; }
+	bool				IsCommentStart() const {
+		return ( GetCharClass( *mCur ) & sLexerCharTable::CHAR_COMMENT ) != 0 
+				&& mProfile.GetCommentType( mFlags, *mCur, PeekChar() ) != COMMENT_NONE;
+	}
+	bool 				IsNegativeNumber( ePunctuation const punc ) const;
+	bool				IsNumberStartingWithDecimalPoint( ePunctuation const punc ) const;
 	bool				SkipWhitespace();
 	bool				SkipComments();
+	void				SkipCommentBody( eCommentType const ct );
+	bool				TrackLines() const { return ( mFlags & FLAG_NO_LINES ) == 0; }
+	void				SkipWhitespaceAndComments();
+	bool				IsNumberStart( ePunctuation const punc ) const;
 	bool				AtEnd() const { return mCur >= mEnd || *mCur == '\0'; }
+	// at the end, or stopped in a comment that goes on past the window
+	bool				OutOfText() const { return AtEnd() || mOpenComment != COMMENT_NONE; }
+	// lexes the next token into all of view but its offset and length, which are [start, end)
+	bool				LexToken( sTokenView & view, char const * & start, char const * & end );
+	// as LexToken, but only for names
+	bool				LexName( sTokenView & view, char const * & start, char const * & end );
+	bool				ScanString( ePunctuation const punc, sTokenView & view, char const * & start, char const * & end );
+	bool				ScanNumber( sTokenView & view, char const * & start, char const * & end );
+	bool				ScanName( sTokenView & view, char const * & start, char const * & end );
+	// sets the offset and length of a view, if they fit
+	bool				FinishView( char const * start, char const * end, sTokenView & view ) const;
+	void				MakeToken( sTokenView const & view, char const * start, char const * end, cToken & token ) const;
+	// NextToken( sTokenView & ) skipping the types not in typeMask
+	bool				NextView( sTokenView & view, uint32_t const typeMask );
+	// the line lexing has reached, which is past any tokens peeked at
+	int32_t				GetLexLine() const;
+
+	// a token lexed by PeekNextToken and not yet taken
+	struct sLookahead {
+		sTokenView		mView;			// all but the offset and length, which are [mStart, mEnd)
+		char const *	mStart;
+		char const *	mEnd;
+		// where the lexer was before the token
+		char const *	mCur;
+		char const *	mLineStart;
+		int32_t			mLine;
+	};
+
+	// lexes one more token into the lookahead
+	bool				LexAhead();
+	// moves back to the first token peeked at and forgets the lookahead, for the functions that don't use it
+	void				DropLookahead();
 
 private:
 	std::string			mName;
 
-	static const int 	PUNC_TABLE_SIZE = 255;
-	ePunctuation		mPunctuationTable[PUNC_TABLE_SIZE];
-	char const *		mPunctuationNames = nullptr;
-	int					mNumPunctuation = 0;
-
 	char const *		mText = nullptr;
 	size_t				mLen = 0;
 	uint32_t			mFlags = 0;
@@ -300,11 +539,61 @@ private:
 	char const *		mLineStart = nullptr;
 	int32_t				mLine = -1;
 	int32_t				mFileIndex = -1;
+	bool				mSpeculative = false;	// lexing ahead from a guessed state, so errors may not be real and aren't reported
+	bool				mFinal = true;			// false while the text is a window of a stream with more to come
+	eCommentType		mOpenComment = COMMENT_NONE;	// the comment a window ended in
+	size_t				mHeldColumns = 0;		// characters of the line before mText when mLineStart is held at mText
+
+	sLookahead			mLookahead[LOOKAHEAD_SIZE];	// a ring of the tokens peeked at
+	uint32_t			mLookaheadFirst = 0;
+	uint32_t			mLookaheadCount = 0;
 
 	mutable std::string		mErrorMsg;
+};
+
+//==============================================================
+// cRuntimeLexerProfile
+//
+// The profile of cLexer: comment rules are function pointers and the
+// punctuation can be changed per instance.
+//==============================================================
+class cRuntimeLexerProfile {
+public:
+	// the comment functions may end a comment anywhere, so cLexerT steps through them a character at a time
+	static constexpr bool		SCAN_AHEAD = false;
+
+	cRuntimeLexerProfile();
+
+	// takes the comment functions and punctuation from initParms, keeping the defaults for any not given
+	void						Init( cLexerBase::sInitParms const & initParms );
 
-	CommentTypeFn		mCommentTypeFn = nullptr;
-	CommentEndFn		mCommentEndFn = nullptr;
+	sLexerCharTable const &		GetCharTable() const { return *mCharTable; }
+
+	cLexerBase::eCommentType	GetCommentType( uint32_t const flags, char const curChar, char const nextChar ) const {
+		return mCommentTypeFn( flags, curChar, nextChar );
+	}
+	bool						IsCommentEnd( uint32_t const flags, cLexerBase::eCommentType const commentType, 
+										char const curChar, char const nextChar ) const {
+		return mCommentEndFn( flags, commentType, curChar, nextChar );
+	}
+
+private:
+	cLexerBase::CommentTypeFn			mCommentTypeFn;
+	cLexerBase::CommentEndFn			mCommentEndFn;
+	sLexerCharTable const *				mCharTable;
+	std::shared_ptr< sLexerCharTable >	mOwnCharTable;		// only for non-default punctuation, shared by copies
+};
+
+//==============================================================
+// cLexer
+//
+// A lexer whose comment rules are passed in at run time. Prefer one of
+// the lexers in lexerprofiles.h when the language is known up front.
+//==============================================================
+class cLexer : public cLexerT< cRuntimeLexerProfile > {
+public:
+	cLexer( char const * name, char const * text, size_t const len, const uint32_t flags = 0 );
+	cLexer( char const * name, char const * text, size_t const len, const sInitParms & initParms );
 };
 
-} // namespace otter
\ No newline at end of file
+} // namespace otter
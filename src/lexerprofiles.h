@@ -0,0 +1,111 @@
+/*______________________________________________________________________________________________
+
+Filename: 	lexerprofiles.h
+Purpose:	Compile-time language profiles for cLexerT.
+Date:		10/18/2026
+______________________________________________________________________________________________*/
+
+#pragma once
+
+#include "lexer.h"
+
+namespace otter {
+
+//==============================================================
+// sCLexerProfile
+//
+// // to the end of the line and /* */ blocks.
+//==============================================================
+struct sCLexerProfile {
+	static constexpr sLexerCharTable	CHAR_TABLE = MakeLexerCharTable( cLexerBase::DEFAULT_PUNCTUATION, "/" );
+	static constexpr bool				SCAN_AHEAD = true;
+	static constexpr char				BLOCK_COMMENT_END[] = "*/";
+
+	static constexpr sLexerCharTable const & GetCharTable() { return CHAR_TABLE; }
+
+	static constexpr cLexerBase::eCommentType GetCommentType( uint32_t const flags, char const curChar, char const nextChar ) {
+		if ( curChar == '/' && nextChar == '*' ) {
+			return cLexerBase::COMMENT_BLOCK;
+		}
+		if ( curChar == '/' && nextChar == '/' ) {
+			return cLexerBase::COMMENT_LINE;
+		}
+		return cLexerBase::COMMENT_NONE;
+	}
+
+	static constexpr bool IsCommentEnd( uint32_t const flags, cLexerBase::eCommentType const commentType,
+			char const curChar, char const nextChar ) {
+		if ( commentType == cLexerBase::COMMENT_BLOCK ) {
+			return curChar == '*' && nextChar == '/';
+		}
+		return curChar == '\n';
+	}
+};
+
+//==============================================================
+// sHashLexerProfile
+//
+// # to the end of the line, as in shell scripts, Python or config files.
+//==============================================================
+struct sHashLexerProfile {
+	static constexpr sLexerCharTable	CHAR_TABLE = MakeLexerCharTable( cLexerBase::DEFAULT_PUNCTUATION, "#" );
+	static constexpr bool				SCAN_AHEAD = true;
+	static constexpr char				BLOCK_COMMENT_END[] = "\0";	// no block comments
+
+	static constexpr sLexerCharTable const & GetCharTable() { return CHAR_TABLE; }
+
+	static constexpr cLexerBase::eCommentType GetCommentType( uint32_t const flags, char const curChar, char const nextChar ) {
+		return curChar == '#' ? cLexerBase::COMMENT_HASH : cLexerBase::COMMENT_NONE;
+	}
+
+	static constexpr bool IsCommentEnd( uint32_t const flags, cLexerBase::eCommentType const commentType,
+			char const curChar, char const nextChar ) {
+		return curChar == '\n';
+	}
+};
+
+//==============================================================
+// sLuaLexerProfile
+//
+// -- to the end of the line, and blocks from [] to ]]. These are the
+// rules LUFFA has always scanned Lua with; note that --[[ is taken as
+// a line comment.
+//==============================================================
+struct sLuaLexerProfile {
+	static constexpr sLexerCharTable	CHAR_TABLE = MakeLexerCharTable( cLexerBase::DEFAULT_PUNCTUATION, "-[" );
+	static constexpr bool				SCAN_AHEAD = true;
+	static constexpr char				BLOCK_COMMENT_END[] = "]]";
+
+	static constexpr sLexerCharTable const & GetCharTable() { return CHAR_TABLE; }
+
+	static constexpr cLexerBase::eCommentType GetCommentType( uint32_t const flags, char const curChar, char const nextChar ) {
+		if ( curChar == '-' && nextChar == '-' ) {
+			return cLexerBase::COMMENT_LINE;
+		}
+		if ( curChar == '[' && nextChar == ']' ) {
+			return cLexerBase::COMMENT_BLOCK;
+		}
+		return cLexerBase::COMMENT_NONE;
+	}
+
+	static constexpr bool IsCommentEnd( uint32_t const flags, cLexerBase::eCommentType const commentType,
+			char const curChar, char const nextChar ) {
+		if ( commentType == cLexerBase::COMMENT_BLOCK ) {
+			return curChar == ']' && nextChar == ']';
+		}
+		return curChar == '\n';
+	}
+};
+
+// with SCAN_AHEAD, cLexerT skips names, line comments and block comments in runs rather
+// than a character at a time. That needs line comments to end at '\n', block comments at
+// BLOCK_COMMENT_END, and names to run over letters, digits and '_' unchecked.
+static_assert( HasPlainNameChars( sCLexerProfile::CHAR_TABLE ), "sCLexerProfile cannot scan ahead" );
+static_assert( HasPlainNameChars( sHashLexerProfile::CHAR_TABLE ), "sHashLexerProfile cannot scan ahead" );
+static_assert( HasPlainNameChars( sLuaLexerProfile::CHAR_TABLE ), "sLuaLexerProfile cannot scan ahead" );
+
+typedef cLexerT< sCLexerProfile >		cCLexer;
+typedef cLexerT< sHashLexerProfile >	cHashLexer;
+typedef cLexerT< sLuaLexerProfile >		cLuaLexer;
+
+} // namespace otter
@@ -0,0 +1,265 @@
+/*______________________________________________________________________________________________
+
+Filename: 	lexerscan.h
+Purpose:	Vectorised scanning of character runs for the lexer.
+Date:		10/18/2026
+______________________________________________________________________________________________*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined( __AVX2__ )
+#	include <immintrin.h>
+#	define OT_SCAN_AVX2
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#	include <emmintrin.h>
+#	define OT_SCAN_SSE2
+#endif
+
+#if defined( _MSC_VER )
+#	include <intrin.h>
+#endif
+
+namespace otter {
+
+inline uint32_t PopCount32( uint32_t const x ) {
+#if defined( _MSC_VER )
+	return __popcnt( x );
+#else
+	return static_cast< uint32_t >( __builtin_popcount( x ) );
+#endif
+}
+
+// index of the lowest set bit, x must not be 0
+inline uint32_t LowestBit32( uint32_t const x ) {
+#if defined( _MSC_VER )
+	unsigned long index;
+	_BitScanForward( &index, x );
+	return index;
+#else
+	return static_cast< uint32_t >( __builtin_ctz( x ) );
+#endif
+}
+
+// index of the highest set bit, x must not be 0
+inline uint32_t HighestBit32( uint32_t const x ) {
+#if defined( _MSC_VER )
+	unsigned long index;
+	_BitScanReverse( &index, x );
+	return index;
+#else
+	return 31 - static_cast< uint32_t >( __builtin_clz( x ) );
+#endif
+}
+
+//==============================================================
+// Scanning works on SCAN_WIDTH bytes at a time with AVX2 or SSE2,
+// whichever the build targets. Plain loops handle the tail of every
+// run, or all of it when neither is available.
+//==============================================================
+#if defined( OT_SCAN_AVX2 )
+typedef __m256i scanVec_t;
+constexpr size_t SCAN_WIDTH = 32;
+inline scanVec_t	ScanLoad( char const * p ) { return _mm256_loadu_si256( reinterpret_cast< __m256i const * >( p ) ); }
+inline scanVec_t	ScanEq( scanVec_t const v, char const ch ) { return _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ch ) ); }
+inline scanVec_t	ScanOr( scanVec_t const a, scanVec_t const b ) { return _mm256_or_si256( a, b ); }
+inline uint32_t		ScanMask( scanVec_t const v ) { return static_cast< uint32_t >( _mm256_movemask_epi8( v ) ); }
+// bytes in [lo, hi]
+inline scanVec_t	ScanRange( scanVec_t const v, char const lo, char const hi ) {
+	// signed compares, fine for the ASCII ranges used here
+	return _mm256_andnot_si256( _mm256_or_si256( _mm256_cmpgt_epi8( _mm256_set1_epi8( lo ), v ),
+			_mm256_cmpgt_epi8( v, _mm256_set1_epi8( hi ) ) ), _mm256_set1_epi8( -1 ) );
+}
+#elif defined( OT_SCAN_SSE2 )
+typedef __m128i scanVec_t;
+constexpr size_t SCAN_WIDTH = 16;
+inline scanVec_t	ScanLoad( char const * p ) { return _mm_loadu_si128( reinterpret_cast< __m128i const * >( p ) ); }
+inline scanVec_t	ScanEq( scanVec_t const v, char const ch ) { return _mm_cmpeq_epi8( v, _mm_set1_epi8( ch ) ); }
+inline scanVec_t	ScanOr( scanVec_t const a, scanVec_t const b ) { return _mm_or_si128( a, b ); }
+inline uint32_t		ScanMask( scanVec_t const v ) { return static_cast< uint32_t >( _mm_movemask_epi8( v ) ); }
+// bytes in [lo, hi]
+inline scanVec_t	ScanRange( scanVec_t const v, char const lo, char const hi ) {
+	// signed compares, fine for the ASCII ranges used here
+	return _mm_andnot_si128( _mm_or_si128( _mm_cmplt_epi8( v, _mm_set1_epi8( lo ) ),
+			_mm_cmpgt_epi8( v, _mm_set1_epi8( hi ) ) ), _mm_set1_epi8( -1 ) );
+}
+#endif
+
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+// all bits for a full vector
+constexpr uint32_t SCAN_FULL_MASK = SCAN_WIDTH == 32 ? 0xFFFFFFFFu : ( 1u << SCAN_WIDTH ) - 1;
+#endif
+
+//==============================================================
+// CountNewlines
+//
+// Returns the number of '\n' in [begin, end) and, if there are any,
+// points lineStart just past the last one.
+//==============================================================
+inline int32_t CountNewlines( char const * begin, char const * end, char const * & lineStart ) {
+	int32_t lines = 0;
+	char const * p = begin;
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+	for ( ; end - p >= static_cast< ptrdiff_t >( SCAN_WIDTH ); p += SCAN_WIDTH ) {
+		uint32_t const nl = ScanMask( ScanEq( ScanLoad( p ), '\n' ) );
+		if ( nl != 0 ) {
+			lines += PopCount32( nl );
+			lineStart = p + HighestBit32( nl ) + 1;
+		}
+	}
+#endif
+	for ( ; p < end; ++p ) {
+		if ( *p == '\n' ) {
+			lines++;
+			lineStart = p + 1;
+		}
+	}
+	return lines;
+}
+
+//==============================================================
+// ScanWhitespace
+//
+// Skips ' ', '\t', '\r' and '\n' from cur on and returns the first other
+// character, or end. The newlines passed are added to line, and
+// lineStart is pointed past the last of them.
+//==============================================================
+inline char const * ScanWhitespace( char const * cur, char const * end, int32_t & line, char const * & lineStart ) {
+	char const * p = cur;
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+	for ( ; end - p >= static_cast< ptrdiff_t >( SCAN_WIDTH ); p += SCAN_WIDTH ) {
+		scanVec_t const v = ScanLoad( p );
+		scanVec_t const nlVec = ScanEq( v, '\n' );
+		uint32_t const ws = ScanMask( ScanOr( ScanOr( ScanEq( v, ' ' ), ScanEq( v, '\t' ) ), ScanOr( ScanEq( v, '\r' ), nlVec ) ) );
+		uint32_t nl = ScanMask( nlVec );
+		uint32_t stop = SCAN_WIDTH;
+		if ( ws != SCAN_FULL_MASK ) {
+			stop = LowestBit32( ~ws );
+			// only the newlines before the first non-whitespace character count
+			nl &= stop == 32 ? 0xFFFFFFFFu : ( 1u << stop ) - 1;
+		}
+		if ( nl != 0 ) {
+			line += PopCount32( nl );
+			lineStart = p + HighestBit32( nl ) + 1;
+		}
+		if ( stop != SCAN_WIDTH ) {
+			return p + stop;
+		}
+	}
+#endif
+	for ( ; p < end; ++p ) {
+		char const ch = *p;
+		if ( ch == '\n' ) {
+			line++;
+			lineStart = p + 1;
+		} else if ( ch != ' ' && ch != '\t' && ch != '\r' ) {
+			break;
+		}
+	}
+	return p;
+}
+
+//==============================================================
+// SkipWhitespaceChars
+//
+// ScanWhitespace for when nobody is counting lines.
+//==============================================================
+inline char const * SkipWhitespaceChars( char const * cur, char const * end ) {
+	char const * p = cur;
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+	for ( ; end - p >= static_cast< ptrdiff_t >( SCAN_WIDTH ); p += SCAN_WIDTH ) {
+		scanVec_t const v = ScanLoad( p );
+		uint32_t const ws = ScanMask( ScanOr( ScanOr( ScanEq( v, ' ' ), ScanEq( v, '\t' ) ), ScanOr( ScanEq( v, '\r' ), ScanEq( v, '\n' ) ) ) );
+		if ( ws != SCAN_FULL_MASK ) {
+			return p + LowestBit32( ~ws );
+		}
+	}
+#endif
+	for ( ; p < end; ++p ) {
+		char const ch = *p;
+		if ( ch != ' ' && ch != '\t' && ch != '\r' && ch != '\n' ) {
+			break;
+		}
+	}
+	return p;
+}
+
+//==============================================================
+// FindNewlines
+//
+// Appends the offset from begin of every '\n' in [begin, end) to offsets.
+//==============================================================
+inline void FindNewlines( char const * begin, char const * end, std::vector< size_t > & offsets ) {
+	char const * p = begin;
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+	for ( ; end - p >= static_cast< ptrdiff_t >( SCAN_WIDTH ); p += SCAN_WIDTH ) {
+		uint32_t nl = ScanMask( ScanEq( ScanLoad( p ), '\n' ) );
+		while ( nl != 0 ) {
+			offsets.push_back( ( p - begin ) + LowestBit32( nl ) );
+			nl &= nl - 1;
+		}
+	}
+#endif
+	for ( ; p < end; ++p ) {
+		if ( *p == '\n' ) {
+			offsets.push_back( p - begin );
+		}
+	}
+}
+
+//==============================================================
+// ScanNameChars
+//
+// Returns the first character from cur on that is not a letter, a digit
+// or '_' (or end). Those never end a name, whatever the language.
+//==============================================================
+inline char const * ScanNameChars( char const * cur, char const * end ) {
+	char const * p = cur;
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+	for ( ; end - p >= static_cast< ptrdiff_t >( SCAN_WIDTH ); p += SCAN_WIDTH ) {
+		scanVec_t const v = ScanLoad( p );
+		scanVec_t const name = ScanOr( ScanOr( ScanRange( v, 'a', 'z' ), ScanRange( v, 'A', 'Z' ) ),
+				ScanOr( ScanRange( v, '0', '9' ), ScanEq( v, '_' ) ) );
+		uint32_t const mask = ScanMask( name );
+		if ( mask != SCAN_FULL_MASK ) {
+			return p + LowestBit32( ~mask );
+		}
+	}
+#endif
+	for ( ; p < end; ++p ) {
+		char const ch = *p;
+		if ( !( ( ch >= 'a' && ch <= 'z' ) || ( ch >= 'A' && ch <= 'Z' ) || ( ch >= '0' && ch <= '9' ) || ch == '_' ) ) {
+			break;
+		}
+	}
+	return p;
+}
+
+//==============================================================
+// FindEither
+//
+// Returns the first occurrence of a or b from cur on, or end.
+//==============================================================
+inline char const * FindEither( char const * cur, char const * end, char const a, char const b ) {
+	char const * p = cur;
+#if defined( OT_SCAN_AVX2 ) || defined( OT_SCAN_SSE2 )
+	for ( ; end - p >= static_cast< ptrdiff_t >( SCAN_WIDTH ); p += SCAN_WIDTH ) {
+		scanVec_t const v = ScanLoad( p );
+		uint32_t const mask = ScanMask( ScanOr( ScanEq( v, a ), ScanEq( v, b ) ) );
+		if ( mask != 0 ) {
+			return p + LowestBit32( mask );
+		}
+	}
+#endif
+	for ( ; p < end; ++p ) {
+		if ( *p == a || *p == b ) {
+			break;
+		}
+	}
+	return p;
+}
+
+} // namespace otter
@@ -0,0 +1,146 @@
+/*______________________________________________________________________________________________
+
+Filename: 	lexerstream.cpp
+Purpose:	Lexing text read in a window at a time.
+Date:		10/18/2026
+______________________________________________________________________________________________*/
+
+#include "lexerstream.h"
+#include "lexerprofiles.h"
+
+#include <algorithm>
+#include <type_traits>
+
+#include "debug.h"
+
+namespace otter {
+
+static cLexerBase::sInitParms StreamInitParms( cLexerBase::sInitParms const & initParms ) {
+	cLexerBase::sInitParms parms = initParms;
+	parms.mFlags &= ~cLexerBase::FLAG_NO_LINES;
+	return parms;
+}
+
+template< typename tProfile >
+cStreamLexerT< tProfile >::cStreamLexerT( char const * name, cLexerInput & input, cLexerBase::sInitParms const & initParms,
+		size_t const windowSize )
+	: mLexer( name, nullptr, 0, StreamInitParms( initParms ) )
+	, mInput( input )
+	, mBuffer( std::max( windowSize, MIN_WINDOW_SIZE ) ) {
+	if constexpr ( std::is_same< tProfile, cRuntimeLexerProfile >::value ) {
+		mLexer.mProfile.Init( initParms );
+	}
+	// errors may only be the window running out, real ones are reported here
+	mLexer.mSpeculative = true;
+	mLexer.mLineStart = mBuffer.data();
+	Refill( mBuffer.data() );
+}
+
+template< typename tProfile >
+size_t cStreamLexerT< tProfile >::GetLineStartOffset() const {
+	size_t const offset = mLexer.mLineStart - mBuffer.data();
+	// a line that began before the window has its start held at the window's first character
+	if ( offset == 0 && mLineStartOffset < mBufferOffset ) {
+		return mLineStartOffset;
+	}
+	return mBufferOffset + offset;
+}
+
+template< typename tProfile >
+void cStreamLexerT< tProfile >::Refill( char const * keepFrom ) {
+	mLineStartOffset = GetLineStartOffset();
+
+	size_t const discard = keepFrom - mBuffer.data();
+	size_t const keep = mFill - discard;
+	memmove( mBuffer.data(), keepFrom, keep );
+	mBufferOffset += discard;
+	mFill = keep;
+	if ( mFill == mBuffer.size() ) {
+		// one token fills the whole window
+		mBuffer.resize( mBuffer.size() * 2 );
+	}
+	while ( mFill < mBuffer.size() ) {
+		size_t const read = mInput.Read( mBuffer.data() + mFill, mBuffer.size() - mFill );
+		if ( read == 0 ) {
+			mEndOfInput = true;
+			break;
+		}
+		mFill += read;
+	}
+
+	char const * text = mBuffer.data();
+	mLexer.mText = text;
+	mLexer.mLen = mFill;
+	mLexer.mCur = text;
+	mLexer.mEnd = text + mFill;
+	if ( mLineStartOffset >= mBufferOffset ) {
+		mLexer.mLineStart = text + ( mLineStartOffset - mBufferOffset );
+		mLexer.mHeldColumns = 0;
+	} else {
+		mLexer.mLineStart = text;
+		mLexer.mHeldColumns = mBufferOffset - mLineStartOffset;
+	}
+	mLexer.mFinal = mEndOfInput;
+}
+
+template< typename tProfile >
+bool cStreamLexerT< tProfile >::NextToken( cToken & token ) {
+	token.Clear();
+	token.SetFileIndex( mLexer.mFileIndex );
+
+	if ( mLexer.HadError() ) {
+		return false;
+	}
+
+	for ( ; ; ) {
+		mLexer.SkipWhitespaceAndComments();
+		if ( mLexer.OutOfText() ) {
+			// a zero byte ends the text here too
+			bool const atZero = mLexer.mCur < mLexer.mEnd && mLexer.mOpenComment == cLexerBase::COMMENT_NONE;
+			if ( mEndOfInput || atZero ) {
+				return false;
+			}
+			Refill( mLexer.mCur );
+			continue;
+		}
+
+		// where to start again if the token turns out to run past the window
+		char const * tokenStart = mLexer.mCur;
+		int32_t const line = mLexer.mLine;
+		char const * lineStart = mLexer.mLineStart;
+		size_t const lineStartOffset = GetLineStartOffset();
+
+		sTokenView view;
+		char const * start;
+		char const * end;
+		bool const lexed = mLexer.LexToken( view, start, end );
+		// nothing lexing looks at is more than a character past where it stops
+		if ( mEndOfInput || mLexer.mCur + 1 < mLexer.mEnd ) {
+			if ( !lexed ) {
+				if ( mLexer.HadError() ) {
+					debugout( "%s\n", mLexer.GetError().c_str() );
+				}
+				return false;
+			}
+			mLexer.MakeToken( view, start, end, token );
+			token.SetOffset( token.GetOffset() + mBufferOffset );
+			// the lexer measured from the start of the window if the line began before it
+			size_t const heldLineStartOffset = mBufferOffset + ( lineStart - mBuffer.data() );
+			token.SetLineOffset( token.GetLineOffset() + static_cast< int32_t >( heldLineStartOffset - lineStartOffset ) );
+			return true;
+		}
+
+		mLexer.mCur = tokenStart;
+		mLexer.mLine = line;
+		mLexer.mLineStart = lineStart;
+		mLexer.mErrorMsg.clear();
+		Refill( tokenStart );
+	}
+}
+
+template class cStreamLexerT< cRuntimeLexerProfile >;
+template class cStreamLexerT< sCLexerProfile >;
+template class cStreamLexerT< sHashLexerProfile >;
+template class cStreamLexerT< sLuaLexerProfile >;
+
+} // namespace otter
@@ -0,0 +1,98 @@
+/*______________________________________________________________________________________________
+
+Filename: 	lexerstream.h
+Purpose:	Lexing text read in a window at a time.
+Date:		10/18/2026
+______________________________________________________________________________________________*/
+
+#pragma once
+
+#include <cstdio>
+#include <vector>
+#include "lexer.h"
+
+namespace otter {
+
+//==============================================================
+// cLexerInput
+//
+// Where a cStreamLexerT reads its text from.
+//==============================================================
+class cLexerInput {
+public:
+	virtual ~cLexerInput() {
+	}
+
+	// reads up to size bytes into dest and returns how many, 0 only at the end of the input
+	virtual size_t	Read( char * dest, size_t const size ) = 0;
+};
+
+//==============================================================
+// cFileLexerInput
+//
+// Reads a FILE *, which can be a pipe or stdin. The file is left open.
+//==============================================================
+class cFileLexerInput : public cLexerInput {
+public:
+	cFileLexerInput( FILE * file )
+		: mFile( file ) {
+	}
+
+	virtual size_t	Read( char * dest, size_t const size ) override {
+		return fread( dest, 1, size, mFile );
+	}
+
+private:
+	FILE *	mFile;
+};
+
+//==============================================================
+// cStreamLexerT
+//
+// Lexes a cLexerInput through a window of fixed size, giving the same
+// tokens cLexerT would for the whole text at once. A token that runs
+// past the window is lexed again once the window has been refilled, and
+// a comment that does carries on in the next window without being kept.
+// The window only grows for a single token longer than itself.
+//==============================================================
+template< typename tProfile >
+class cStreamLexerT {
+public:
+	static constexpr size_t	DEFAULT_WINDOW_SIZE = 64 * 1024;
+	static constexpr size_t	MIN_WINDOW_SIZE = 16;
+
+	// lines are always counted, FLAG_NO_LINES is ignored since the text is gone by the time a line is wanted
+	cStreamLexerT( char const * name, cLexerInput & input, cLexerBase::sInitParms const & initParms,
+			size_t const windowSize = DEFAULT_WINDOW_SIZE );
+
+	cStreamLexerT( cStreamLexerT const & other ) = delete;
+	cStreamLexerT & operator = ( cStreamLexerT const & rhs ) = delete;
+
+	// the token's offset is from the start of the stream
+	bool				NextToken( cToken & token );
+
+	int32_t				GetLine() const { return mLexer.mLine; }
+
+	bool				HadError() const { return mLexer.HadError(); }
+	std::string const &	GetError() const { return mLexer.GetError(); }
+
+	size_t				GetWindowSize() const { return mBuffer.size(); }
+
+private:
+	cLexerT< tProfile >	mLexer;
+	cLexerInput &		mInput;
+	std::vector< char >	mBuffer;
+	size_t				mFill = 0;				// how much of mBuffer holds text
+	size_t				mBufferOffset = 0;		// stream offset of mBuffer[0]
+	size_t				mLineStartOffset = 0;	// stream offset of the line start, which may be before mBuffer
+	bool				mEndOfInput = false;
+
+	// drops the text before keepFrom, which must be where the lexer is, and reads more after the rest
+	void				Refill( char const * keepFrom );
+	// the stream offset of the lexer's line start
+	size_t				GetLineStartOffset() const;
+};
+
+typedef cStreamLexerT< cRuntimeLexerProfile >	cStreamLexer;
+
+} // namespace otter
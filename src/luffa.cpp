@@ -9,6 +9,7 @@
 #include <vector>
 #include <iostream>
 #include "fuzzywuzzy.hpp"
+#include "utils.hpp"
 #include <conio.h>
 #include <memory>
 #include <time.h>
@@ -16,7 +17,12 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <string_view>
 #include "lexer.h"
+#include "lexerprofiles.h"
+#include "unionfind.h"
 
 template< typename T >
 class cFileT {
@@ -119,50 +125,55 @@ void Test() {
     std::cout << fuzz::token_sort_ratio(c, d) << '\n';
 }
 
-static otter::cLexer::eCommentType GetLuaCommentType( uint32_t const flags, 
-        char const curChar, char const nextChar ) {
-    if ( curChar == '-' && nextChar == '-' ) {
-        return otter::cLexer::COMMENT_LINE;
-    }
-
-    if ( curChar == '[' && nextChar == ']' ) {
-        return otter::cLexer::COMMENT_BLOCK;
-    }
-	return otter::cLexer::COMMENT_NONE;
-}
-
-static bool IsLuaCommentEnd( uint32_t const flags, 
-        otter::cLexer::eCommentType const commentType, 
-        char const curChar, char const nextChar ) {
-    if ( commentType == otter::cLexer::COMMENT_LINE ) {
-        return curChar == '\n';
-    }
-    if ( commentType == otter::cLexer::COMMENT_BLOCK ) {
-        return curChar == ']' && nextChar == ']';
-    }
-	return false;
-}
-
-bool TokenizeFile( const std::string & fileName, int32_t const fileIndex, std::vector< otter::cTokenString > & tokens ) {
+bool TokenizeFile( const std::string & fileName, int32_t const fileIndex, std::vector< otter::cTokenString > & tokens, 
+        otter::cLineIndex & lineIndex ) {
     cFileT< char > fileBuffer = ReadFile( fileName );
 
-    otter::cLexer::sInitParms initParms;
-    initParms.mCommentTypeFn = GetLuaCommentType;
-    initParms.mCommentEndFn = IsLuaCommentEnd;
+    // lines are only looked up for the words that get reported, so the lexer just gives offsets
+    lineIndex.Build( fileBuffer.GetBuffer(), fileBuffer.GetSize() );
+
+    otter::cLuaLexer::sInitParms initParms;
     initParms.mFileIndex = fileIndex;
+    initParms.mFlags = otter::cLexerBase::FLAG_NO_LINES;
 
-    otter::cLexer lex( fileName.c_str(), fileBuffer.GetBuffer(), fileBuffer.GetSize(), initParms );
+    otter::cLuaLexer lex( fileName.c_str(), fileBuffer.GetBuffer(), fileBuffer.GetSize(), initParms );
 
     otter::cTokenString token;
-    while ( lex.NextToken( token ) ) {
-        // std::cout << "token = '" << token << "'\n";
-        otter::cToken::eTokenType tokenType = token.GetType();
-        switch( tokenType ) {
-            case otter::cToken::NAME:
-                tokens.push_back( token );
-                break;
-            default:
-                break;
+    token.SetType( otter::cToken::NAME );
+    token.SetFileIndex( fileIndex );
+
+    // huge files, like generated data tables, are lexed in chunks on every thread
+    constexpr size_t PARALLEL_FILE_SIZE = 32 * 1024 * 1024;
+    if ( fileBuffer.GetSize() >= PARALLEL_FILE_SIZE ) {
+        std::vector< otter::sTokenView > views;
+        lex.NextTokensParallel( views, std::max( 1u, std::thread::hardware_concurrency() ), 
+                otter::sTokenBatch::TypeBit( otter::cToken::NAME ) );
+        for ( otter::sTokenView const & view : views ) {
+            token.SetText( lex.GetText( view ), view.mLength );
+            token.SetOffset( view.mOffset );
+            tokens.push_back( token );
+        }
+        std::cout << "Found " << tokens.size() << " words in file.\n";
+        return true;
+    }
+
+    // only names are wanted, so the lexer drops everything else before it reaches us
+    constexpr size_t BATCH_SIZE = 256;
+    uint8_t types[BATCH_SIZE];
+    uint32_t offsets[BATCH_SIZE];
+    uint32_t lengths[BATCH_SIZE];
+    otter::sTokenBatch batch;
+    batch.mTypes = types;
+    batch.mOffsets = offsets;
+    batch.mLengths = lengths;
+    batch.mCapacity = BATCH_SIZE;
+    batch.mTypeMask = otter::sTokenBatch::TypeBit( otter::cToken::NAME );
+
+    while ( lex.NextTokens( batch ) ) {
+        for ( size_t i = 0; i < batch.mCount; ++i ) {
+            token.SetText( fileBuffer.GetBuffer() + offsets[i], lengths[i] );
+            token.SetOffset( offsets[i] );
+            tokens.push_back( token );
         }
     }
 
@@ -171,30 +182,141 @@ bool TokenizeFile( const std::string & fileName, int32_t const fileIndex, std::v
     return true;
 }
 
-void FindUniqueWordsInFiles( std::vector< std::string > & files, std::vector< otter::cTokenString >& uniqueWords ) {
+struct sOccurrence {
+    int32_t mFileIndex;
+    uint32_t mOffset;   // in the file, see the file's cLineIndex for the line
+};
+
+void FindUniqueWordsInFiles( std::vector< std::string > & files, std::vector< otter::cTokenString >& uniqueWords, 
+        std::vector< std::string > & processedWords, std::vector< std::vector< sOccurrence > > & occurrences,
+        std::vector< otter::cLineIndex > & lineIndices ) {
     std::vector< otter::cTokenString > tokens;
 
+    lineIndices.resize( files.size() );
     for ( size_t i = 0; i < files.size(); ++i ) {
         std::cout << "Loading file '" << files[i] << "'...";
-        if ( !TokenizeFile( files[i], i, tokens ) ) {
+        if ( !TokenizeFile( files[i], i, tokens, lineIndices[i] ) ) {
             std::cout << " FAILED!\n";
         } else {
             std::cout << "\n";
         }
     }
 
-    // add all words to a hash table to get only unique words
-    std::unordered_map< std::string, int > wordHash;
+    // add all words to a hash table to get only unique words, remembering every place each one was seen.
+    // the keys point into the tokens' own text, which stays put until we return.
+    std::unordered_map< std::string_view, int > wordHash;
 
     for ( size_t i = 0; i < tokens.size(); ++i ) {
-        wordHash.insert( { tokens[i].GetText(), i } );
+        auto const inserted = wordHash.insert( { tokens[i].GetText(), static_cast< int >( uniqueWords.size() ) } );
+        if ( inserted.second ) {
+            // std::cout << "Unique str '" << tokens[i] << "'\n";
+            uniqueWords.push_back( tokens[i] );
+            // normalize once here rather than on every comparison
+            processedWords.push_back( fuzz::utils::full_process( tokens[i].GetText() ) );
+            occurrences.emplace_back();
+        }
+        occurrences[inserted.first->second].push_back( { tokens[i].GetFileIndex(), static_cast< uint32_t >( tokens[i].GetOffset() ) } );
+    }
+}
+
+// Words that normalize to the same string always score 100 against each other, so they are 
+// clustered directly and only one word of each such group takes part in the pairwise scoring.
+// Returns the words that still need to be compared.
+std::vector< uint32_t > CollapseEqualWords( std::vector< std::string > const & processedWords, 
+        otter::cConcurrentUnionFind & clusters ) {
+    std::vector< uint32_t > representatives;
+    std::unordered_map< std::string_view, uint32_t > groups;
+    for ( uint32_t i = 0; i < processedWords.size(); ++i ) {
+        // nothing left after processing (e.g. "_"), so this never matches anything
+        if ( processedWords[i].empty() ) {
+            continue;
+        }
+        auto const inserted = groups.insert( { processedWords[i], i } );
+        if ( inserted.second ) {
+            representatives.push_back( i );
+        } else {
+            clusters.Union( inserted.first->second, i );
+        }
+    }
+    return representatives;
+}
+
+// Scores every pair of words across all hardware threads. Each accepted pair goes straight into 
+// the union-find, so no list of pairs is ever built up.
+void ClusterSimilarWords( std::vector< std::string > const & processedWords, uint32_t const minRatio, 
+        otter::cConcurrentUnionFind & clusters ) {
+    std::vector< uint32_t > const words = CollapseEqualWords( processedWords, clusters );
+    std::atomic< size_t > nextRow( 0 );
+
+    auto worker = [&]() {
+        for ( ; ; ) {
+            size_t const i = nextRow.fetch_add( 1 );
+            if ( i >= words.size() ) {
+                break;
+            }
+            // prepare the bit masks for this word once and score the rest of the row against it
+            fuzz::cached_ratio const firstWord( processedWords[words[i]], false );
+            for ( size_t j = i + 1; j < words.size(); ++j ) {
+                // already known to be in the same cluster, so the score can't change anything
+                if ( clusters.Find( words[i] ) == clusters.Find( words[j] ) ) {
+                    continue;
+                }
+                std::string const & secondWord = processedWords[words[j]];
+                // anything at or below minRatio is rejected, so let the scorer bail out on it early
+                uint32_t ratio = firstWord.score( secondWord, minRatio + 1 );
+                if ( ratio > minRatio ) {
+                    clusters.Union( words[i], words[j] );
+                }
+            }
+        }
+    };
+
+    unsigned int const numThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    std::vector< std::thread > threads;
+    for ( unsigned int i = 0; i < numThreads; ++i ) {
+        threads.emplace_back( worker );
+    }
+    for ( auto & t : threads ) {
+        t.join();
+    }
+}
+
+void PrintClusters( std::vector< otter::cTokenString > const & words, std::vector< std::vector< sOccurrence > > const & occurrences, 
+        std::vector< std::string > const & files, std::vector< otter::cLineIndex > const & lineIndices, 
+        otter::cConcurrentUnionFind & clusters ) {
+    // every root is the smallest index in its cluster, so walking roots in order gives a stable output order
+    std::vector< std::vector< uint32_t > > members( words.size() );
+    for ( uint32_t i = 0; i < words.size(); ++i ) {
+        members[clusters.Find( i )].push_back( i );
     }
 
-    // now turn the hash back into a vector
-    for ( auto it = wordHash.begin(); it != wordHash.end(); ++it ) {
-        // std::cout << "Unique str '" << tokens[it->second] << "'\n";
-        uniqueWords.push_back( tokens[it->second] );
+    size_t numClusters = 0;
+    for ( size_t root = 0; root < members.size(); ++root ) {
+        std::vector< uint32_t > const & cluster = members[root];
+        if ( cluster.size() < 2 ) {
+            continue;
+        }
+        numClusters++;
+
+        // the most used spelling is most likely the intended one
+        uint32_t rep = cluster[0];
+        for ( uint32_t const m : cluster ) {
+            if ( occurrences[m].size() > occurrences[rep].size() ) {
+                rep = m;
+            }
+        }
+
+        std::cout << "(" << cluster.size() << ") '" << words[rep].GetText() << "'\n";
+        for ( uint32_t const m : cluster ) {
+            std::cout << ( m == rep ? "---> '" : "     '" ) << words[m].GetText() << "'";
+            for ( sOccurrence const & o : occurrences[m] ) {
+                std::cout << ", " << files[o.mFileIndex] << ":" << lineIndices[o.mFileIndex].GetLine( o.mOffset );
+            }
+            std::cout << "\n";
+        }
     }
+
+    std::cout << "Found " << numClusters << " clusters of similar words.\n";
 }
 
 void FindMatchingFiles( const char * path, const char * ext, std::vector< std::string > & files ) {
@@ -227,23 +349,17 @@ int main( const int argc, const char ** argv ) {
 #endif
  
     std::vector< otter::cTokenString > uniqueWords;
-    FindUniqueWordsInFiles( files, uniqueWords );
+    std::vector< std::string > processedWords;
+    std::vector< std::vector< sOccurrence > > occurrences;
+    std::vector< otter::cLineIndex > lineIndices;
+    FindUniqueWordsInFiles( files, uniqueWords, processedWords, occurrences, lineIndices );
 
     std::cout << "Found " << uniqueWords.size() << " unique words in file.\n";
 
     std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-    for ( size_t i = 0; i < uniqueWords.size(); ++i ) {
-        otter::cTokenString const & firstWord = uniqueWords[i];
-        for ( size_t j = i + 1; j < uniqueWords.size(); ++j ) {
-            otter::cTokenString const & secondWord = uniqueWords[j];
-            uint32_t ratio = fuzz::ratio( firstWord.GetText(), secondWord.GetText() );
-            if ( ratio > 90 ) {
-                std::cout << "(" << ratio << ")\n";
-                std::cout << "---> '" << firstWord.GetText() << "', " << files[firstWord.GetFileIndex()] << ":" << firstWord.GetLine() << "\n";
-                std::cout << "     '" << secondWord.GetText() << "', " << files[secondWord.GetFileIndex()] << ":" << secondWord.GetLine() << "\n";
-            }
-        }
-    }
+    otter::cConcurrentUnionFind clusters( static_cast< uint32_t >( uniqueWords.size() ) );
+    ClusterSimilarWords( processedWords, 90, clusters );
+    PrintClusters( uniqueWords, occurrences, files, lineIndices, clusters );
     std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 
     std::cout << "Time difference = " << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() / 1000.0f << " seconds" << std::endl;
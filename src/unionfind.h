@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace otter {
+
+//==============================================================
+// cConcurrentUnionFind
+//
+// Disjoint-set forest that any number of threads can Union() into at the
+// same time without taking a lock. Parents only ever point at a smaller
+// index, so a root is always the smallest index in its set and the final
+// partition does not depend on the order pairs arrive in.
+//
+// Find() may be called concurrently with Union(), but a set's root is only
+// stable once all unions have finished.
+//==============================================================
+class cConcurrentUnionFind {
+public:
+	explicit cConcurrentUnionFind( uint32_t const size )
+		: mParents( new std::atomic< uint32_t >[size] )
+		, mSize( size ) {
+		for ( uint32_t i = 0; i < size; ++i ) {
+			mParents[i].store( i, std::memory_order_relaxed );
+		}
+	}
+
+	cConcurrentUnionFind( cConcurrentUnionFind const & other ) = delete;
+	cConcurrentUnionFind & operator = ( cConcurrentUnionFind const & rhs ) = delete;
+
+	uint32_t	GetSize() const { return mSize; }
+
+	uint32_t	Find( uint32_t x ) {
+		for ( ; ; ) {
+			uint32_t parent = mParents[x].load( std::memory_order_acquire );
+			if ( parent == x ) {
+				return x;
+			}
+			uint32_t const grandParent = mParents[parent].load( std::memory_order_acquire );
+			if ( grandParent != parent ) {
+				// path halving -- losing this race to another thread is harmless since
+				// the grand parent is still an ancestor of x
+				mParents[x].compare_exchange_weak( parent, grandParent, std::memory_order_release, std::memory_order_relaxed );
+			}
+			x = grandParent;
+		}
+	}
+
+	// returns true if a and b were in different sets
+	bool		Union( uint32_t a, uint32_t b ) {
+		for ( ; ; ) {
+			a = Find( a );
+			b = Find( b );
+			if ( a == b ) {
+				return false;
+			}
+			// always hang the larger root under the smaller one
+			if ( a < b ) {
+				std::swap( a, b );
+			}
+			uint32_t expected = a;
+			if ( mParents[a].compare_exchange_strong( expected, b, std::memory_order_acq_rel ) ) {
+				return true;
+			}
+			// a stopped being a root while we looked at it, so try again from the top
+		}
+	}
+
+private:
+	std::unique_ptr< std::atomic< uint32_t >[] >	mParents;
+	uint32_t										mSize;
+};
+
+} // namespace otter